@@ -0,0 +1,354 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "scene.h"
+
+// Bidirectional path tracing over the same SceneT as shade_path.
+//
+// A camera subpath and a light subpath are traced per sample and every pair of
+// prefixes (s light vertices, t camera vertices) is connected. Strategies are
+// combined with the power heuristic, using the recursive pdf ratios of Veach's
+// thesis (as in pbrt's MISWeight). Light tracing onto the film (t = 1) is not
+// used, so it is left out of the weights too; every remaining strategy produces
+// a contribution for the pixel that owns the camera ray.
+//
+// Emitters are the scene's emissive primitives that provide the area-light
+// interface (RectGeom, Sphere) plus the RectLights, which camera rays cannot hit.
+// Emissive surfaces absorb, lambert surfaces scatter diffusely, mirrors are delta.
+
+struct BdVertex {
+    enum Kind { CAMERA, LIGHT, SURFACE };
+    Kind kind = SURFACE;
+    Vec3 p, n;                 // n faces the side the path arrived from (emitting normal for LIGHT)
+    Color beta{1,1,1};         // path throughput up to and including this vertex' position
+    Color Le;                  // LIGHT: emitted radiance
+    const Material* mat = nullptr;
+    int prim = -1, index = -1; // SURFACE: hit primitive (kind in Prims..., index)
+    bool delta = false;
+    bool front = true;         // SURFACE: hit the outward side (n is then the outward normal)
+    bool hittable = true;      // LIGHT: can a camera subpath hit it (false for RectLights)
+    double pdfFwd = 0, pdfRev = 0;   // area densities, own direction / reverse direction
+};
+
+struct BdEmitter {
+    int prim, index;           // prim = kind in Prims..., or -1 for lights[index]
+    double area, pick;         // pick = probability of choosing this emitter
+    Color Le;
+};
+
+namespace bdpt_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+inline double sq(double x) { return x*x; }
+inline double remap0(double x) { return x != 0 ? x : 1.0; }
+
+// solid-angle pdf at 'from' towards 'to' converted to an area density at 'to'
+inline double to_area(double pdfDir, const BdVertex& from, const BdVertex& to) {
+    Vec3 d = to.p - from.p;
+    double d2 = dot(d, d);
+    if (d2 == 0) return 0;
+    if (to.kind == BdVertex::CAMERA) return pdfDir / d2;
+    return pdfDir * std::fabs(dot(to.n, d)) / (d2 * std::sqrt(d2));
+}
+
+inline bool is_lambert(const BdVertex& v) {
+    return v.kind == BdVertex::SURFACE && v.mat && v.mat->type == MatType::LAMBERT;
+}
+
+// BSDF value towards direction w (unit), lambert only; 0 on the far side
+inline Color bsdf(const BdVertex& v, const Vec3& w) {
+    if (!is_lambert(v) || dot(v.n, w) <= 0) return Color(0,0,0);
+    return v.mat->albedo * (1.0/kPi);
+}
+
+inline Color mul(const Color& a, const Color& b) { return Color(a.r*b.r, a.g*b.g, a.b*b.b); }
+inline bool is_black(const Color& c) { return c.r <= 0 && c.g <= 0 && c.b <= 0; }
+
+template <class SceneType, size_t... I>
+void collect_emitters(const SceneType& S, std::vector<BdEmitter>& out, std::index_sequence<I...>) {
+    auto one = [&](auto K, const auto& v){
+        using P = typename std::decay_t<decltype(v)>::value_type;
+        if constexpr (is_emitter_prim<P>::value) {
+            for (int i = 0; i < (int)v.size(); ++i)
+                if (v[i].mat.type == MatType::EMISSIVE) out.push_back({ int(K), i, v[i].area(), 0, v[i].mat.emission });
+        }
+    };
+    (one(std::integral_constant<size_t, I>{}, std::get<I>(S.geom)), ...);
+}
+
+template <class SceneType, size_t... I>
+Vec3 emitter_point(const SceneType& S, const BdEmitter& e, double u, double v, Vec3& n, std::index_sequence<I...>) {
+    Vec3 p;
+    auto one = [&](auto K){
+        using P = typename std::tuple_element_t<K, decltype(S.geom)>::value_type;
+        if constexpr (is_emitter_prim<P>::value) {
+            if (e.prim == int(K)) p = std::get<K>(S.geom)[e.index].sample_point(u, v, n);
+        }
+    };
+    (one(std::integral_constant<size_t, I>{}), ...);
+    return p;
+}
+
+// all emitters of S: emissive area-light primitives, then the RectLights; pick by power
+template <class SceneType>
+std::vector<BdEmitter> scene_emitters(const SceneType& S) {
+    std::vector<BdEmitter> out;
+    collect_emitters(S, out, std::make_index_sequence<std::tuple_size_v<decltype(S.geom)>>{});
+    for (int i = 0; i < (int)S.lights.size(); ++i)
+        out.push_back({ -1, i, S.lights[i].area(), 0, S.lights[i].Le });
+    double total = 0;
+    for (auto& e : out) { e.pick = e.area * (e.Le.r + e.Le.g + e.Le.b); total += e.pick; }
+    for (auto& e : out) e.pick = total > 0 ? e.pick / total : 0;
+    return out;
+}
+
+} // namespace bdpt_detail
+
+// Cheap to construct: the emitter list (scene_emitters) is built once per render and
+// shared by reference, and the subpath vertices live in per-thread storage that is
+// reused by every sample on the thread.
+template <class SceneType>
+struct BDPT {
+    const SceneType& S;
+    int maxDepth;                              // max path length in edges, like shade_path's depth
+    const std::vector<BdEmitter>& emitters;
+    std::vector<BdVertex>& cam;
+    std::vector<BdVertex>& light;
+
+    BDPT(const SceneType& scene, int depth, const std::vector<BdEmitter>& em)
+        : S(scene), maxDepth(std::max(1, depth)), emitters(em), cam(scratch(0)), light(scratch(1)) {
+        cam.reserve(maxDepth + 1); light.reserve(maxDepth);
+    }
+
+    // radiance along camera ray r
+    template <class Rng>
+    Color radiance(const Ray& r, Rng& rng) {
+        using namespace bdpt_detail;
+        cam.clear(); light.clear();
+        Color L(0,0,0);
+
+        BdVertex c0; c0.kind = BdVertex::CAMERA; c0.p = r.origin;
+        cam.push_back(c0);
+        Color escaped = walk(r, Color(1,1,1), 1.0, maxDepth, cam, rng);
+        L = L + escaped;   // background is only reachable by camera paths: weight 1
+
+        if (!emitters.empty()) {
+            BdVertex l0;
+            if (sample_light(l0, rng)) {
+                light.push_back(l0);
+                // cosine emission around the emitting normal
+                Sample2 e = next_2d(rng);
+                Vec3 w = cosine_dir(l0.n, e.u, e.v);
+                double pdfDir = dot(l0.n, w) / kPi;
+                if (pdfDir > 0 && maxDepth > 1)
+                    walk(Ray(l0.p, w), l0.beta * kPi, pdfDir, maxDepth - 1, light, rng);
+            }
+        }
+
+        for (int t = 2; t <= (int)cam.size(); ++t)
+            for (int s = 0; s <= (int)light.size(); ++s) {
+                if (s + t - 1 > maxDepth) break;
+                BdVertex sampled;
+                Color c = connect(s, t, sampled, rng);
+                if (is_black(c)) continue;
+                L = L + c * mis_weight(s, t, sampled);
+            }
+        return L;
+    }
+
+private:
+    static std::vector<BdVertex>& scratch(int k) {
+        thread_local std::vector<BdVertex> v[2];
+        return v[k];
+    }
+
+    static Vec3 cosine_dir(const Vec3& n, double u1, double u2) {
+        double r1 = 2.0*bdpt_detail::kPi*u1, r2s = std::sqrt(u2);
+        Vec3 a = (std::fabs(n.x) > 0.1) ? Vec3(0,1,0) : Vec3(1,0,0);
+        Vec3 t = normalize(cross(a,n)), b = cross(n,t);
+        return normalize(t*(std::cos(r1)*r2s) + b*(std::sin(r1)*r2s) + n*std::sqrt(1.0-u2));
+    }
+
+    // pick an emitter by power and a point on it uniformly by area
+    template <class Rng>
+    bool sample_light(BdVertex& v, Rng& rng) const {
+        double x = next_1d(rng);
+        const BdEmitter* e = &emitters.back();
+        for (const auto& em : emitters) { if (x < em.pick) { e = &em; break; } x -= em.pick; }
+        if (e->pick <= 0 || e->area <= 0) return false;
+        v = BdVertex{};
+        v.kind = BdVertex::LIGHT;
+        Sample2 pt = next_2d(rng);
+        double u1 = pt.u, u2 = pt.v;
+        if (e->prim < 0) {
+            const RectLight& Lr = S.lights[e->index];
+            v.p = Lr.sample(u1, u2); v.n = Lr.normal; v.hittable = false;
+        } else {
+            v.p = bdpt_detail::emitter_point(S, *e, u1, u2, v.n,
+                      std::make_index_sequence<std::tuple_size_v<decltype(S.geom)>>{});
+        }
+        v.Le = e->Le;
+        v.pdfFwd = e->pick / e->area;
+        v.beta = v.Le * (1.0 / v.pdfFwd);
+        return true;
+    }
+
+    // area density of starting a light subpath at surface vertex v (an emitter hit)
+    double pdf_light_origin(const BdVertex& v) const {
+        for (const auto& e : emitters) if (e.prim == v.prim && e.index == v.index) return e.pick / e.area;
+        return 0.0;
+    }
+
+    // area density at 'to' of emitting from light (or emitter surface) vertex v
+    static double pdf_light(const BdVertex& v, const BdVertex& to) {
+        Vec3 w = normalize(to.p - v.p);
+        return bdpt_detail::to_area(std::fabs(dot(v.n, w)) / bdpt_detail::kPi, v, to);
+    }
+
+    // area density at 'next' of sampling next from v (prev is implied by v.n for lambert)
+    static double pdf(const BdVertex& v, const BdVertex& next) {
+        if (v.kind == BdVertex::LIGHT) return pdf_light(v, next);
+        if (!bdpt_detail::is_lambert(v)) return 0.0;
+        Vec3 w = normalize(next.p - v.p);
+        double c = dot(v.n, w);
+        return c > 0 ? bdpt_detail::to_area(c / bdpt_detail::kPi, v, next) : 0.0;
+    }
+
+    // extends 'path' by up to maxVerts vertices; returns escaped background radiance
+    template <class Rng>
+    Color walk(Ray ray, Color beta, double pdfDir, int maxVerts, std::vector<BdVertex>& path, Rng& rng) const {
+        using namespace bdpt_detail;
+        bool fromCamera = path.front().kind == BdVertex::CAMERA;
+        for (int bounces = 0; bounces < maxVerts; ) {
+            auto h = S.trace_first(ray, 1e-4, 1e9);
+            if (!h.hit) return fromCamera ? mul(beta, S.background(ray)) : Color(0,0,0);
+
+            const Material* m = S.material_of(h);
+            if (!fromCamera && m->type == MatType::EMISSIVE) break;   // emitters absorb
+            BdVertex v;
+            v.p = h.rec.p; v.n = h.rec.n; v.mat = m; v.beta = beta;
+            v.prim = h.kind; v.index = h.index; v.front = h.rec.front_face;
+            v.pdfFwd = to_area(pdfDir, path.back(), v);
+            path.push_back(v);
+            ++bounces;
+            if (m->type == MatType::EMISSIVE || bounces >= maxVerts) break;
+
+            BdVertex& cur = path.back();
+            BdVertex& prev = path[path.size() - 2];
+            Vec3 wi; double pdfRevDir;
+            if (m->type == MatType::MIRROR) {
+                wi = reflect(ray.dir, cur.n);
+                cur.delta = true; pdfDir = 0; pdfRevDir = 0;
+            } else {
+                Sample2 d = next_2d(rng);
+                wi = cosine_dir(cur.n, d.u, d.v);
+                pdfDir = dot(cur.n, wi) / kPi;
+                pdfRevDir = dot(cur.n, -ray.dir) / kPi;
+                beta = mul(beta, m->albedo);
+                if (bounces > 3) {   // roulette past the third vertex, shade_path's survival probability
+                    double ps = std::min(0.95, std::max({m->albedo.r, m->albedo.g, m->albedo.b}));
+                    if (next_1d(rng) > ps) break;
+                    beta = beta * (1.0/ps);
+                }
+            }
+            prev.pdfRev = to_area(pdfRevDir, cur, prev);
+            ray = Ray(cur.p, wi);
+        }
+        return Color(0,0,0);
+    }
+
+    // unweighted contribution of strategy (s, t); for s == 1 the light vertex is
+    // sampled afresh and returned in 'sampled'
+    template <class Rng>
+    Color connect(int s, int t, BdVertex& sampled, Rng& rng) const {
+        using namespace bdpt_detail;
+        const BdVertex& pt = cam[t-1];
+        if (s == 0) {   // camera subpath ended on an emitter; only the front face emits
+            if (pt.kind != BdVertex::SURFACE || pt.mat->type != MatType::EMISSIVE || !pt.front) return Color(0,0,0);
+            return mul(pt.beta, pt.mat->emission);
+        }
+        if (!is_lambert(pt)) return Color(0,0,0);
+        const BdVertex* qs;
+        if (s == 1) {
+            if (!sample_light(sampled, rng)) return Color(0,0,0);
+            qs = &sampled;
+        } else {
+            qs = &light[s-1];
+            if (!is_lambert(*qs)) return Color(0,0,0);
+        }
+        Vec3 d = qs->p - pt.p;
+        double d2 = dot(d, d), dist = std::sqrt(d2);
+        if (dist < 1e-6) return Color(0,0,0);
+        Vec3 w = d / dist;                       // pt -> qs
+        Color fc = bsdf(pt, w);
+        if (is_black(fc)) return Color(0,0,0);
+        Color fl;
+        double cosq;
+        if (qs->kind == BdVertex::LIGHT) {
+            cosq = dot(qs->n, -w);               // one-sided emitters
+            if (cosq <= 0) return Color(0,0,0);
+            fl = Color(1,1,1);
+        } else {
+            fl = bsdf(*qs, -w);
+            if (is_black(fl)) return Color(0,0,0);
+            cosq = std::fabs(dot(qs->n, w));
+        }
+        double G = std::fabs(dot(pt.n, w)) * cosq / d2;
+        if (S.occluded(pt.p, w, dist)) return Color(0,0,0);
+        return mul(mul(pt.beta, fc), mul(fl, qs->beta)) * G;
+    }
+
+    double mis_weight(int s, int t, BdVertex& sampled) {
+        using namespace bdpt_detail;
+        if (s + t == 2) return 1.0;
+        BdVertex* lv = (s == 1) ? &sampled : light.data();
+        BdVertex* qs = s > 0 ? &lv[s-1] : nullptr;
+        BdVertex* pt = &cam[t-1];
+        BdVertex* qsMinus = s > 1 ? &lv[s-2] : nullptr;
+        BdVertex* ptMinus = &cam[t-2];
+
+        if (s == 0 && pdf_light_origin(*pt) == 0) return 1.0;   // not samplable: only strategy
+
+        // temporarily re-express the endpoint densities for this connection
+        double sv[4] = { pt->pdfRev, ptMinus->pdfRev, qs ? qs->pdfRev : 0, qsMinus ? qsMinus->pdfRev : 0 };
+        bool ptDelta = pt->delta, qsDelta = qs ? qs->delta : false;
+        pt->delta = false;
+        if (qs) qs->delta = false;
+        pt->pdfRev = s > 0 ? pdf(*qs, *pt) : pdf_light_origin(*pt);
+        ptMinus->pdfRev = s > 0 ? pdf(*pt, *ptMinus) : pdf_light(*pt, *ptMinus);
+        if (qs) qs->pdfRev = pdf(*pt, *qs);
+        if (qsMinus) qsMinus->pdfRev = pdf(*qs, *qsMinus);
+
+        double sum = 0, ri = 1;
+        for (int i = t - 1; i > 1; --i) {       // i == 1 would be light tracing (t = 1), unused
+            ri *= sq(remap0(cam[i].pdfRev) / remap0(cam[i].pdfFwd));
+            if (!cam[i].delta && !cam[i-1].delta) sum += ri;
+        }
+        ri = 1;
+        for (int i = s - 1; i >= 0; --i) {
+            ri *= sq(remap0(lv[i].pdfRev) / remap0(lv[i].pdfFwd));
+            bool deltaPrev = i > 0 ? lv[i-1].delta : !lv[0].hittable;
+            if (!lv[i].delta && !deltaPrev) sum += ri;
+        }
+
+        pt->pdfRev = sv[0]; ptMinus->pdfRev = sv[1];
+        if (qs) qs->pdfRev = sv[2];
+        if (qsMinus) qsMinus->pdfRev = sv[3];
+        pt->delta = ptDelta;
+        if (qs) qs->delta = qsDelta;
+        return 1.0 / (1.0 + sum);
+    }
+};
+
+// one BDPT sample for camera ray r; paths have at most maxDepth edges. Collects the
+// emitters on every call: renderers build the list once and use BDPT directly.
+template <class SceneType, class Rng>
+inline Color bdpt_radiance(const SceneType& scene, const Ray& r, int maxDepth, Rng& rng) {
+    std::vector<BdEmitter> em = bdpt_detail::scene_emitters(scene);
+    return BDPT<SceneType>(scene, maxDepth, em).radiance(r, rng);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "color.h"
+
+// Running per-pixel sums of radiance samples. Row j=0 is the bottom of the
+// image (same convention as the camera's v), so writers flip vertically.
+// A film may hold only a window of rows [row0, row0+rows) of a W x H image
+// (streamed output); whole-image writers expect row0 == 0 and rows == H.
+struct Film {
+    int W = 0, H = 0;
+    int row0 = 0, rows = 0;
+    int samples = 0;            // samples per pixel accumulated so far
+    std::vector<Color> sum;
+
+    Film() = default;
+    Film(int w, int h) : W(w), H(h), rows(h), sum(size_t(w) * h) {}
+    Film(int w, int h, int r0, int n) : W(w), H(h), row0(r0), rows(n), sum(size_t(w) * n) {}
+
+    Color& at(int i, int j) { return sum[size_t(j - row0) * W + i]; }
+    const Color& at(int i, int j) const { return sum[size_t(j - row0) * W + i]; }
+
+    // mean radiance of pixel (i,j)
+    Color mean(int i, int j) const {
+        return samples ? at(i, j) * (1.0 / samples) : Color(0,0,0);
+    }
+
+    void clear() { std::fill(sum.begin(), sum.end(), Color(0,0,0)); samples = 0; }
+};
+
+inline bool write_ppm(const std::string& path, const Film& f) {
+    std::vector<uint8_t> pixels(size_t(f.W) * f.H * 3);
+    for (int j = 0; j < f.H; ++j)
+        for (int i = 0; i < f.W; ++i) {
+            size_t idx = (size_t(f.H-1-j) * f.W + i) * 3; // flip vertically for PPM
+            to_u8(f.mean(i, j), pixels[idx+0], pixels[idx+1], pixels[idx+2], 1.0);
+        }
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << f.W << " " << f.H << "\n255\n";
+    out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    return bool(out);
+}
+
+// Float PFM (little-endian, bottom row first, which is exactly our row order).
+inline bool write_pfm(const std::string& path, const Film& f) {
+    std::vector<float> data(size_t(f.W) * f.H * 3);
+    for (int j = 0; j < f.H; ++j)
+        for (int i = 0; i < f.W; ++i) {
+            Color c = f.mean(i, j);
+            size_t idx = (size_t(j) * f.W + i) * 3;
+            data[idx+0] = float(c.r); data[idx+1] = float(c.g); data[idx+2] = float(c.b);
+        }
+    std::ofstream out(path, std::ios::binary);
+    out << "PF\n" << f.W << " " << f.H << "\n-1.0\n";
+    out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+    return bool(out);
+}
+
+// Load a P6 PPM or PF PFM into a film holding one sample per pixel.
+// 8-bit PPMs are decoded back to linear radiance with the inverse of to_u8's gamma.
+inline bool read_image(const std::string& path, Film& f) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic; int w = 0, h = 0;
+    in >> magic >> w >> h;
+    if (!in || w <= 0 || h <= 0) return false;
+    if (magic == "P6") {
+        int maxv = 0; in >> maxv; in.get();
+        if (maxv != 255) return false;
+        std::vector<uint8_t> px(size_t(w) * h * 3);
+        in.read(reinterpret_cast<char*>(px.data()), px.size());
+        if (!in) return false;
+        f = Film(w, h);
+        auto lin = [](uint8_t x){ return std::pow(x / 255.0, 2.2); };
+        for (int j = 0; j < h; ++j)
+            for (int i = 0; i < w; ++i) {
+                size_t idx = (size_t(h-1-j) * w + i) * 3;
+                f.at(i, j) = Color(lin(px[idx]), lin(px[idx+1]), lin(px[idx+2]));
+            }
+    } else if (magic == "PF") {
+        double scale = 0; in >> scale; in.get();
+        if (scale >= 0) return false;   // only little-endian, as written above
+        std::vector<float> data(size_t(w) * h * 3);
+        in.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(float));
+        if (!in) return false;
+        f = Film(w, h);
+        for (size_t k = 0; k < f.sum.size(); ++k) f.sum[k] = Color(data[3*k], data[3*k+1], data[3*k+2]);
+    } else {
+        return false;
+    }
+    f.samples = 1;
+    return true;
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+#include "camera.h"
+#include "scene.h"
+#include "film.h"
+#include "render.h"
+#include "thread_pool.h"
+
+// Look-dev cache for re-rendering one camera and geometry with different materials.
+//
+// gbuffer_capture traces the camera rays once and keeps, per sample, the ray, the
+// first hit (primitive, point, normal) and the sample's RNG seed. gbuffer_shade then
+// shades from the cached hits and also keeps each sample's radiance together with
+// the set of primitives its path touched (PathRecord). After a material-only edit
+// it compares the scene's materials with those of the previous shade and re-shades
+// just the samples whose path touched an edited primitive; everything else is
+// reused. Because every sample has its own seed, a partial re-shade gives exactly
+// the image a full re-shade would.
+//
+// Camera and geometry must stay as captured (capture again otherwise). Edits that
+// change what the MIS integrator samples as a light (a primitive becoming or ceasing
+// to be emissive, emission changes, RectLight edits) and any RenderParams change
+// re-shade every sample. BDPT is not resumed from a cached hit and always re-shades.
+// Memory is about 130 bytes per sample.
+template <class SceneType>
+struct GBuffer {
+    struct Sample {
+        Vec3 dir;                    // camera ray direction (origin is the camera eye)
+        Hit rec;                     // first hit
+        int kind = -1, index = -1;   // first-hit primitive; kind -1 = ray escaped
+        Color L;                     // radiance from the last shade (clamped)
+        uint64_t touched = 0;        // PathRecord mask from the last shade
+    };
+    int W = 0, H = 0, spp = 0;
+    Vec3 eye;
+    std::vector<Sample> samples;     // ((j*W + i)*spp + s), j = film row
+    bool shaded = false;
+    int reshaded = 0;                // samples re-shaded by the last gbuffer_shade
+
+    // state of the last shade, to find what changed
+    std::vector<Material> mats;      // all primitives, in Prims... order
+    std::vector<RectLight> lights;
+    RenderParams params;
+};
+
+namespace gbuffer_detail {
+
+inline double unit(uint64_t x) { return (x >> 11) * (1.0 / 9007199254740992.0); }
+
+inline uint64_t sample_seed(uint64_t seed, size_t k) { return mix_seed(seed ^ mix_seed(uint64_t(k))); }
+
+inline bool same(const Color& a, const Color& b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+inline bool same(const Material& a, const Material& b) {
+    return a.type == b.type && same(a.albedo, b.albedo) && same(a.emission, b.emission);
+}
+inline bool same(const RectLight& a, const RectLight& b) {
+    auto eq = [](const Vec3& x, const Vec3& y){ return x.x == y.x && x.y == y.y && x.z == y.z; };
+    return eq(a.v0, b.v0) && eq(a.e1, b.e1) && eq(a.e2, b.e2) && eq(a.normal, b.normal) && same(a.Le, b.Le);
+}
+// every field that changes the shaded result (guide and split by identity)
+inline bool same(const RenderParams& a, const RenderParams& b) {
+    return a.ls == b.ls && a.depth == b.depth && a.seed == b.seed && a.clamp == b.clamp && a.integrator == b.integrator
+        && a.sampler == b.sampler && a.guide == b.guide && a.split == b.split;
+}
+
+// fn(kind, index, material) for every primitive in the scene
+template <class SceneType, class Fn>
+void for_each_material(const SceneType& S, Fn fn) {
+    int kind = 0;
+    std::apply([&](const auto&... v){
+        ((std::for_each(v.begin(), v.end(), [&, i = 0](const auto& g) mutable { fn(kind, i++, g.mat); }), ++kind), ...);
+    }, S.geom);
+}
+
+} // namespace gbuffer_detail
+
+// Trace and cache the first hits of spp jittered camera rays per pixel.
+template <class SceneType>
+inline void gbuffer_capture(ThreadPool& pool, const SceneType& scene, const Camera& cam,
+                            int W, int H, int spp, const RenderParams& p, GBuffer<SceneType>& gb) {
+    using namespace gbuffer_detail;
+    gb.W = W; gb.H = H; gb.spp = spp; gb.eye = cam.eye;
+    gb.samples.assign(size_t(W) * H * spp, {});
+    gb.shaded = false;
+    pool.parallel_for(H, [&](int j, int){
+        for (int i = 0; i < W; ++i)
+            for (int s = 0; s < spp; ++s) {
+                size_t k = (size_t(j) * W + i) * spp + s;
+                uint64_t key = sample_seed(p.seed, k);
+                Ray r = cam.get_ray((i + unit(mix_seed(key ^ 1))) / (W - 1), (j + unit(mix_seed(key ^ 2))) / (H - 1));
+                auto h = scene.trace_first(r, 1e-4, 1e9);
+                auto& c = gb.samples[k];
+                c.dir = r.dir;
+                if (h.hit) { c.rec = h.rec; c.kind = h.kind; c.index = h.index; }
+            }
+    });
+}
+
+// Shade the cached samples with the scene's current materials into film (W x H,
+// sums, film.samples = spp), re-shading only what changed since the last call.
+// Returns false if the scene no longer matches the capture, or if p asks for what a
+// cached sample cannot replay: a QMC sampler (samples are seeded per sample) or
+// split_rr (it does not start from a hit).
+template <class SceneType>
+inline bool gbuffer_shade(ThreadPool& pool, const SceneType& scene, const RenderParams& p,
+                          GBuffer<SceneType>& gb, Film& film) {
+    using namespace gbuffer_detail;
+    if (p.sampler != SamplerType::RANDOM || p.split) return false;
+    std::vector<Material> mats;
+    for_each_material(scene, [&](int, int, const Material& m){ mats.push_back(m); });
+    if (gb.shaded && mats.size() != gb.mats.size()) return false;
+
+    bool all = !gb.shaded || !same(p, gb.params) || p.integrator == Integrator::BDPT
+            || scene.lights.size() != gb.lights.size();
+    for (size_t l = 0; !all && l < scene.lights.size(); ++l) all = !same(scene.lights[l], gb.lights[l]);
+
+    uint64_t changed = 0;
+    if (!all) {
+        size_t n = 0;
+        for_each_material(scene, [&](int kind, int index, const Material& m){
+            const Material& old = gb.mats[n++];
+            if (same(m, old)) return;
+            changed |= PathRecord::bit(kind, index);
+            // MIS samples every emissive primitive as a light from every lambert hit
+            if (p.integrator == Integrator::MIS && (m.type == MatType::EMISSIVE || old.type == MatType::EMISSIVE)) all = true;
+        });
+    }
+
+    const int W = gb.W, H = gb.H, spp = gb.spp;
+    if (film.W != W || film.H != H) film = Film(W, H);
+    std::vector<BdEmitter> em;
+    RenderParams rp = with_emitters(scene, p, em);
+    std::vector<int> rowCount(H, 0);
+    pool.parallel_for(H, [&](int j, int){
+        int count = 0;
+        for (int i = 0; i < W; ++i) {
+            Color acc(0,0,0);
+            for (int s = 0; s < spp; ++s) {
+                size_t k = (size_t(j) * W + i) * spp + s;
+                auto& c = gb.samples[k];
+                if (all || (c.touched & changed)) {
+                    std::mt19937_64 rng(sample_seed(p.seed, k));
+                    Ray r(gb.eye, c.dir);
+                    PathRecord rec;
+                    Color L(0,0,0);
+                    if (p.integrator == Integrator::BDPT) L = radiance(scene, r, rp, rng);
+                    else if (c.kind < 0) L = p.depth > 0 ? scene.background(r) : Color(0,0,0);
+                    else if (p.depth > 0) {
+                        typename SceneType::HitAny h{ true, c.rec, c.kind, c.index };
+                        L = p.integrator == Integrator::MIS
+                            ? scene.shade_path_mis_hit(r, h, p.depth, p.ls, rng, 0.0, &rec)
+                            : scene.shade_path_hit(r, h, p.depth, p.ls, rng, &rec, p.guide);
+                    }
+                    double m = std::max({L.r, L.g, L.b});
+                    if (p.clamp > 0 && m > p.clamp) L = L * (p.clamp/m);
+                    c.L = L; c.touched = rec.mask;
+                    ++count;
+                }
+                acc = acc + c.L;
+            }
+            film.at(i, j) = acc;
+        }
+        rowCount[j] = count;
+    });
+    film.samples = spp;
+
+    gb.reshaded = 0;
+    for (int c : rowCount) gb.reshaded += c;
+    gb.mats = std::move(mats);
+    gb.lights = scene.lights;
+    gb.params = p;
+    gb.shaded = true;
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "scene.h"
+#include "material.h"
+#include "rectangle.h"
+#include "triangle.h"
+#include "light.h"
+#include "color.h"
+
+// Hexagonal room from rt_room.cpp: walls, floor/roof, roof lamp, spheres and
+// a small tetrahedron. Shared by every tool that renders "the room".
+
+// Bare shell: 6 walls, floor and roof. Works for any SceneT with RectGeom and TriGeom.
+template <class SceneType>
+inline void build_hex_room(SceneType& S){
+    // materials
+    Material wallLambert { MatType::LAMBERT, Color(0.7,0.7,0.7) };
+    Material floorLambert{ MatType::LAMBERT, Color(0.7,0.7,0.7) };
+    Material roofLambert { MatType::LAMBERT, Color(0.7,0.7,0.7) };
+
+    // XY vertices (closed polygon)
+    Vec3 P[6] = { Vec3(0, 6, 0), Vec3(10, 6, 0), Vec3(13, 0, 0),
+                  Vec3(10,-6, 0), Vec3(0,-6, 0), Vec3(-3, 0, 0) };
+
+    // 6 wall rectangles: v0 at z=-5; e1 = +z(10); e2 = edge along XY
+    for (int i=0;i<6;++i){
+        Vec3 a = P[i], b = P[(i+1)%6];
+        Vec3 v0(a.x, a.y, -5);
+        Vec3 e1(0,0,10);
+        Vec3 e2(b.x - a.x, b.y - a.y, 0);
+        S.add(RectGeom{ Rectangle(v0, e1, e2), wallLambert });
+    }
+
+    // Floor (z = -5) and Roof (z = +5)
+    // Central rectangle between (0,-6) and (10,6) in XY
+    auto add_floor_rect = [&](double z, const Material& m){
+        Vec3 v0(0,-6,z);
+        Vec3 e1(10, 0, 0);  // along +x
+        Vec3 e2( 0,12, 0);  // along +y
+        S.add(RectGeom{ Rectangle(v0, e1, e2), m });
+    };
+    auto add_floor_tris = [&](double z, const Material& m){
+        // Left wedge: (-3,0)-(0,6)-(0,-6)
+        S.add(TriGeom{ Triangle(Vec3(-3,0,z), Vec3(0,6,z),  Vec3(0,-6,z)), m });
+        // Right wedge: (10,6)-(13,0)-(10,-6)
+        S.add(TriGeom{ Triangle(Vec3(10,6,z), Vec3(13,0,z), Vec3(10,-6,z)), m });
+    };
+
+    add_floor_rect(-5, floorLambert);
+    add_floor_tris(-5, floorLambert);
+    add_floor_rect(+5, roofLambert);
+    add_floor_tris(+5, roofLambert);
+}
+
+// The furnished room exactly as rendered by rt_room.cpp.
+inline void build_hex_room_scene(Scene& scene){
+    build_hex_room(scene);
+
+    Material lamp { MatType::EMISSIVE, Color(0,0,0), Color(1.5,1.5,1.5) }; // Le = (1,1,1)
+    Material red{ MatType::LAMBERT, Color(0.9,0.2,0.2) };
+    Material mirror { MatType::MIRROR, Color(0,0,0) };
+    Material blueLambert { MatType::LAMBERT, Color(0.2, 0.2, 0.9) };
+    Material greenLambert  { MatType::LAMBERT, Color(0.2, 0.9, 0.2) };
+
+    auto& rects = scene.prims<RectGeom>();
+    rects[0].mat = greenLambert;   // right wall (y=+6)
+    rects[3].mat = blueLambert;  // left wall  (y=-6)
+    rects[1].mat = mirror;  // left wall  (y=-6)
+
+    //Spheres
+    scene.add(Sphere(Vec3(5.0, 0.0, -3), 0.8, red));
+    scene.add(Sphere(Vec3(5.0, 2, -3), 0.65, mirror));
+
+    // Roof area light at z=+5 facing downward (same 4x4 as before, centered near x~4,y~0)
+    Vec3 v0 = Vec3(2,-2,5), e1 = Vec3(0,4,0), e2 = Vec3(4,0,0), nL = Vec3(0,0,-1);
+    scene.lights.emplace_back(v0, e1, e2, nL, Color(1.3,1.3,1.3));
+
+    {
+    Vec3 v0g = Vec3(2, -2, 4.9);   // corner
+    Vec3 e1g = Vec3(0, 4, 0);      // along +y
+    Vec3 e2g = Vec3(4, 0, 0);      // along +x
+    RectGeom lampRect{ Rectangle(v0g, e1g, e2g), lamp };
+    scene.add(lampRect);
+    }
+
+    // --- Add a small tetrahedron (polygonal object) ---
+    Material yellowPoly{ MatType::LAMBERT, Color(0.9,0.9,0.2) };
+
+    // vertices (centered near x≈4.3, y≈-1.0, z≈-2.3)
+    Vec3 A(5.3, -3, -4);
+    Vec3 B(5.6, -1.5, -4);
+    Vec3 C(5.3, -3, 0.3);
+    Vec3 D(5.3, -2.2, -4);
+
+    // 4 faces (triangles)
+    scene.add(TriGeom{ Triangle(A, B, C), yellowPoly });
+    scene.add(TriGeom{ Triangle(A, C, D), yellowPoly });
+    scene.add(TriGeom{ Triangle(A, D, B), yellowPoly });
+    scene.add(TriGeom{ Triangle(B, D, C), yellowPoly });
+}
+
+// Grey shell lit only by the roof lamp. Compiled without sphere traversal and
+// without the mirror branch.
+using BareRoomScene = SceneT<MatList<MatType::LAMBERT, MatType::EMISSIVE>, RectGeom, TriGeom>;
+
+template <class SceneType>
+inline void build_bare_room(SceneType& S){
+    build_hex_room(S);
+    Material lamp { MatType::EMISSIVE, Color(0,0,0), Color(1.5,1.5,1.5) };
+    S.add(RectGeom{ Rectangle(Vec3(2,-2,4.9), Vec3(0,4,0), Vec3(4,0,0)), lamp });
+}
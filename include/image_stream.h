@@ -0,0 +1,310 @@
+#pragma once
+// Streaming image output. Finished rows (top row first) are pushed while the
+// render continues; they are grouped into strips that go through a bounded ring
+// to a few encoder threads, which compress strips in parallel and append them to
+// the file in order. Memory is capacity x stripRows rows, whatever the image size.
+//
+//   .png  RGB8, one zlib stream split into independently deflated strips
+//         (sync-flushed, adler32 combined), one IDAT chunk per strip. Link with -lz.
+//   .qoi  RGB8, each strip encoded with the previous strip's last pixel as the
+//         running pixel and an empty index, which any QOI decoder reads as one stream.
+//   .pfm  float RGB, linear radiance (rows seeked into PFM's bottom-up order).
+//   .ppm  RGB8 P6 (default for unknown extensions).
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "color.h"
+
+enum class ImageFormat { PPM, PFM, PNG, QOI };
+
+inline ImageFormat format_from_path(const std::string& path) {
+    auto ends = [&](const char* e){
+        size_t n = std::strlen(e);
+        return path.size() >= n && path.compare(path.size() - n, n, e) == 0;
+    };
+    if (ends(".png")) return ImageFormat::PNG;
+    if (ends(".qoi")) return ImageFormat::QOI;
+    if (ends(".pfm")) return ImageFormat::PFM;
+    return ImageFormat::PPM;
+}
+
+class ImageStream {
+public:
+    ImageStream(const std::string& path, int w, int h, int stripRows = 16, int capacity = 4, int encoders = 2)
+        : W(w), H(h), stripRows(std::max(1, stripRows)), capacity(std::max(1, capacity)),
+          fmt(format_from_path(path)), out(path, std::ios::binary)
+    {
+        write_header();
+        cur.px.reserve(size_t(this->stripRows) * W * 3);
+        for (int t = 0; t < std::max(1, encoders); ++t) workers.emplace_back([this]{ encode_loop(); });
+    }
+    ~ImageStream() { finish(); }
+    ImageStream(const ImageStream&) = delete;
+    ImageStream& operator=(const ImageStream&) = delete;
+
+    // next image row (top to bottom), W linear radiance values
+    void push_row(const Color* row) {
+        if (rowsPushed >= H) return;
+        for (int i = 0; i < W; ++i) {
+            cur.px.push_back(float(row[i].r)); cur.px.push_back(float(row[i].g)); cur.px.push_back(float(row[i].b));
+        }
+        ++rowsPushed;
+        if (rowsPushed - cur.y0 == stripRows || rowsPushed == H) submit();
+    }
+
+    // waits for all strips, writes the trailer; true if the file is complete
+    bool finish() {
+        if (finished) return ok;
+        finished = true;
+        if (!cur.px.empty()) submit();
+        { std::lock_guard<std::mutex> lk(m); quit = true; }
+        cv_work.notify_all();
+        for (auto& t : workers) t.join();
+        write_trailer();
+        out.flush();
+        ok = ok && bool(out) && rowsPushed == H;
+        return ok;
+    }
+
+    int width() const { return W; }
+    int height() const { return H; }
+
+private:
+    struct Strip {
+        int index = 0, y0 = 0;
+        std::vector<float> px;      // rows top-first, RGB
+        std::vector<float> prev;    // row above y0 (empty for the first strip)
+        int rows(int w) const { return int(px.size() / (size_t(w) * 3)); }
+    };
+    struct Encoded { std::string data; uint32_t adler = 1; size_t rawLen = 0; };
+
+    void submit() {
+        Strip s;
+        s.index = nextIndex++; s.y0 = cur.y0;
+        s.prev = lastRow;
+        lastRow.assign(cur.px.end() - size_t(W) * 3, cur.px.end());
+        s.px.swap(cur.px);
+        cur.y0 = rowsPushed;
+        cur.px.reserve(size_t(stripRows) * W * 3);
+        std::unique_lock<std::mutex> lk(m);
+        cv_space.wait(lk, [&]{ return inFlight < capacity; });   // the ring is full: wait for the writer
+        ++inFlight;
+        queue.push_back(std::move(s));
+        cv_work.notify_one();
+    }
+
+    void encode_loop() {
+        while (true) {
+            Strip s;
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv_work.wait(lk, [&]{ return quit || !queue.empty(); });
+                if (queue.empty()) return;
+                s = std::move(queue.front()); queue.pop_front();
+            }
+            bool last = s.y0 + s.rows(W) == H;
+            Encoded e = encode(s, last);
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv_turn.wait(lk, [&]{ return nextWrite == s.index; });
+            }
+            append(s, e, last);   // only the strip whose turn it is touches the file
+            std::lock_guard<std::mutex> lk(m);
+            ++nextWrite; --inFlight;
+            cv_turn.notify_all();
+            cv_space.notify_all();
+        }
+    }
+
+    static uint8_t u8(float x) {
+        uint8_t R, G, B; to_u8(Color(x, 0, 0), R, G, B, 1.0); return R;
+    }
+    void to_bytes(const float* src, size_t n, uint8_t* dst) const { for (size_t k = 0; k < n; ++k) dst[k] = u8(src[k]); }
+
+    // ---- per-strip encoders (run in parallel) ----
+    Encoded encode(const Strip& s, bool last) const {
+        switch (fmt) {
+            case ImageFormat::PNG: return encode_png(s, last);
+            case ImageFormat::QOI: return encode_qoi(s);
+            case ImageFormat::PFM: {
+                Encoded e; e.data.resize(s.px.size() * sizeof(float));
+                std::memcpy(&e.data[0], s.px.data(), e.data.size());
+                return e;
+            }
+            default: {
+                Encoded e; e.data.resize(s.px.size());
+                to_bytes(s.px.data(), s.px.size(), reinterpret_cast<uint8_t*>(&e.data[0]));
+                return e;
+            }
+        }
+    }
+
+    Encoded encode_png(const Strip& s, bool last) const {
+        const size_t stride = size_t(W) * 3;
+        const int n = s.rows(W);
+        std::vector<uint8_t> rgb(s.px.size()), above(stride, 0), raw((stride + 1) * n), cand(stride), best(stride);
+        to_bytes(s.px.data(), s.px.size(), rgb.data());
+        if (!s.prev.empty()) to_bytes(s.prev.data(), stride, above.data());
+        for (int r = 0; r < n; ++r) {
+            const uint8_t* cur = &rgb[r * stride];
+            const uint8_t* up  = r ? &rgb[(r-1) * stride] : above.data();   // zeros above row 0, as PNG defines
+            // adaptive filter: smallest sum of |signed residuals| over None/Sub/Up/Avg/Paeth
+            long bestCost = -1; uint8_t bestType = 0;
+            for (uint8_t t = 0; t < 5; ++t) {
+                long cost = 0;
+                for (size_t k = 0; k < stride; ++k) {
+                    int a = k >= 3 ? cur[k-3] : 0, b = up[k], c = k >= 3 ? up[k-3] : 0, pred = 0;
+                    if (t == 1) pred = a;
+                    else if (t == 2) pred = b;
+                    else if (t == 3) pred = (a + b) / 2;
+                    else if (t == 4) {
+                        int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                        pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                    }
+                    cand[k] = uint8_t(cur[k] - pred);
+                    cost += std::abs(int(int8_t(cand[k])));
+                }
+                if (bestCost < 0 || cost < bestCost) { bestCost = cost; bestType = t; best.swap(cand); }
+            }
+            raw[r * (stride + 1)] = bestType;
+            std::memcpy(&raw[r * (stride + 1) + 1], best.data(), stride);
+        }
+
+        Encoded e;
+        e.rawLen = raw.size();
+        e.adler = adler32(1L, raw.data(), uInt(raw.size()));
+        z_stream z{};
+        deflateInit2(&z, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);   // raw deflate
+        e.data.resize(deflateBound(&z, uLong(raw.size())) + 16);
+        z.next_in = raw.data(); z.avail_in = uInt(raw.size());
+        z.next_out = reinterpret_cast<Bytef*>(&e.data[0]); z.avail_out = uInt(e.data.size());
+        deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);   // only the last strip sets BFINAL
+        e.data.resize(e.data.size() - z.avail_out);
+        deflateEnd(&z);
+        return e;
+    }
+
+    Encoded encode_qoi(const Strip& s) const {
+        struct Px { uint8_t r, g, b, a; bool operator==(const Px& o) const { return r==o.r && g==o.g && b==o.b && a==o.a; } };
+        Px index[64] = {};
+        Px prev{0, 0, 0, 255};
+        std::vector<uint8_t> rgb(s.px.size());
+        to_bytes(s.px.data(), s.px.size(), rgb.data());
+        if (!s.prev.empty()) {
+            size_t k = s.prev.size() - 3;
+            prev = { u8(s.prev[k]), u8(s.prev[k+1]), u8(s.prev[k+2]), 255 };
+        }
+        Encoded e;
+        std::string& o = e.data;
+        o.reserve(rgb.size() + rgb.size() / 4);
+        int run = 0;
+        const size_t n = rgb.size() / 3;
+        for (size_t k = 0; k < n; ++k) {
+            Px px{ rgb[3*k], rgb[3*k+1], rgb[3*k+2], 255 };
+            if (px == prev) {
+                if (++run == 62 || k + 1 == n) { o.push_back(char(0xc0 | (run - 1))); run = 0; }
+                continue;
+            }
+            if (run) { o.push_back(char(0xc0 | (run - 1))); run = 0; }
+            int h = (px.r*3 + px.g*5 + px.b*7 + px.a*11) % 64;
+            if (index[h] == px) {
+                o.push_back(char(h));
+            } else {
+                index[h] = px;
+                int vr = int8_t(px.r - prev.r), vg = int8_t(px.g - prev.g), vb = int8_t(px.b - prev.b);
+                int vgr = vr - vg, vgb = vb - vg;
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    o.push_back(char(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                    o.push_back(char(0x80 | (vg + 32)));
+                    o.push_back(char((vgr + 8) << 4 | (vgb + 8)));
+                } else {
+                    o.push_back(char(0xfe)); o.push_back(char(px.r)); o.push_back(char(px.g)); o.push_back(char(px.b));
+                }
+            }
+            prev = px;
+        }
+        return e;
+    }
+
+    // ---- serial part: headers and in-order appends ----
+    static void be32(std::string& s, uint32_t v) {
+        for (int k = 3; k >= 0; --k) s.push_back(char((v >> (8*k)) & 0xff));
+    }
+    void png_chunk(const char* type, const std::string& data) {
+        std::string c; be32(c, uint32_t(data.size()));
+        c.append(type, 4); c += data;
+        uint32_t crc = crc32(0L, reinterpret_cast<const Bytef*>(c.data() + 4), uInt(c.size() - 4));
+        be32(c, crc);
+        out.write(c.data(), c.size());
+    }
+
+    void write_header() {
+        if (fmt == ImageFormat::PNG) {
+            out.write("\x89PNG\r\n\x1a\n", 8);
+            std::string ihdr; be32(ihdr, uint32_t(W)); be32(ihdr, uint32_t(H));
+            ihdr += std::string("\x08\x02\x00\x00\x00", 5);   // 8-bit RGB, no interlace
+            png_chunk("IHDR", ihdr);
+        } else if (fmt == ImageFormat::QOI) {
+            std::string h("qoif"); be32(h, uint32_t(W)); be32(h, uint32_t(H));
+            h.push_back(3); h.push_back(0);
+            out.write(h.data(), h.size());
+        } else if (fmt == ImageFormat::PFM) {
+            out << "PF\n" << W << " " << H << "\n-1.0\n";
+            pfmData = out.tellp();
+        } else {
+            out << "P6\n" << W << " " << H << "\n255\n";
+        }
+    }
+
+    void append(const Strip& s, const Encoded& e, bool last) {
+        if (fmt == ImageFormat::PNG) {
+            std::string d;
+            if (s.index == 0) d += "\x78\x9c";   // zlib header (deflate, 32K window)
+            d += e.data;
+            adler = s.index == 0 ? e.adler : adler32_combine(adler, e.adler, z_off_t(e.rawLen));
+            if (last) be32(d, uint32_t(adler));
+            png_chunk("IDAT", d);
+        } else if (fmt == ImageFormat::PFM) {
+            const size_t rowBytes = size_t(W) * 3 * sizeof(float);
+            for (int r = 0; r < s.rows(W); ++r) {
+                out.seekp(pfmData + std::streamoff(size_t(H - 1 - (s.y0 + r)) * rowBytes));
+                out.write(e.data.data() + r * rowBytes, rowBytes);
+            }
+        } else {
+            out.write(e.data.data(), e.data.size());
+        }
+        if (!out) ok = false;
+    }
+
+    void write_trailer() {
+        if (fmt == ImageFormat::PNG) png_chunk("IEND", "");
+        else if (fmt == ImageFormat::QOI) out.write("\0\0\0\0\0\0\0\1", 8);
+    }
+
+    int W, H, stripRows, capacity;
+    ImageFormat fmt;
+    std::ofstream out;
+    std::streampos pfmData = 0;
+    uLong adler = 1;
+
+    Strip cur;
+    std::vector<float> lastRow;
+    int rowsPushed = 0, nextIndex = 0;
+    bool finished = false, ok = true;
+
+    std::mutex m;
+    std::condition_variable cv_work, cv_space, cv_turn;
+    std::deque<Strip> queue;
+    std::vector<std::thread> workers;
+    int inFlight = 0, nextWrite = 0;
+    bool quit = false;
+};
@@ -1,7 +1,53 @@
 #pragma once
+#include <algorithm>
 #include "vec3.h"
 #include "color.h"
 
+// Spherical rectangle (Urena, Fajardo, King 2013): uniform sampling of the solid
+// angle a rectangle with orthogonal edges ex, ey at corner s subtends from o.
+// pdf of every sample is 1/S (S = solid angle); S == 0 means o is in the plane.
+struct SphQuad {
+    Vec3 o, x, y, z;
+    double z0, x0, y0, x1, y1;
+    double b0, b1, k, S = 0;
+
+    SphQuad(const Vec3& s, const Vec3& ex, const Vec3& ey, const Vec3& O) : o(O) {
+        const double pi = 3.14159265358979323846;
+        double exl = length(ex), eyl = length(ey);
+        x = ex / exl; y = ey / eyl; z = cross(x, y);
+        Vec3 d = s - o;
+        z0 = dot(d, z);
+        if (z0 > 0) { z = -z; z0 = -z0; }
+        if (z0 > -1e-9) return;                  // o lies in the rectangle's plane
+        x0 = dot(d, x); y0 = dot(d, y);
+        x1 = x0 + exl;  y1 = y0 + eyl;
+        // normals of the four planes through o and the edges
+        Vec3 n0 = normalize(Vec3(0, z0, -y0));
+        Vec3 n1 = normalize(Vec3(-z0, 0, x1));
+        Vec3 n2 = normalize(Vec3(0, -z0, y1));
+        Vec3 n3 = normalize(Vec3(z0, 0, -x0));
+        auto ang = [](double c){ return std::acos(std::clamp(c, -1.0, 1.0)); };
+        double g0 = ang(-dot(n0, n1)), g1 = ang(-dot(n1, n2));
+        double g2 = ang(-dot(n2, n3)), g3 = ang(-dot(n3, n0));
+        b0 = n0.z; b1 = n2.z;
+        k = 2.0*pi - g2 - g3;
+        S = std::max(0.0, g0 + g1 - k);
+    }
+
+    // point on the rectangle for (u,v) in [0,1)^2
+    Vec3 sample(double u, double v) const {
+        double au = u * S + k;
+        double fu = (std::cos(au) * b0 - b1) / std::sin(au);
+        double cu = std::clamp((fu > 0 ? 1.0 : -1.0) / std::sqrt(fu*fu + b0*b0), -1.0, 1.0);
+        double xu = std::clamp(-(cu * z0) / std::sqrt(std::max(1e-12, 1.0 - cu*cu)), x0, x1);
+        double d  = std::sqrt(xu*xu + z0*z0);
+        double h0 = y0 / std::sqrt(d*d + y0*y0), h1 = y1 / std::sqrt(d*d + y1*y1);
+        double hv = h0 + v * (h1 - h0), hv2 = hv*hv;
+        double yv = (hv2 < 1.0 - 1e-9) ? (hv * d) / std::sqrt(1.0 - hv2) : y1;
+        return o + x*xu + y*yv + z*z0;
+    }
+};
+
 struct RectLight {
     // v0 is one corner on the plane, e1/e2 are edge vectors
     Vec3 v0, e1, e2;        // area = |e1 x e2|
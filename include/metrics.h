@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "film.h"
+
+// Image error of a (partially converged) film against a reference of the same size.
+// rmse/relmse are measured on linear radiance, psnr on the displayed values
+// (gamma 2.2, clamped to [0,1]) so it matches what the PPMs show.
+struct ImageError {
+    double rmse = 0, relmse = 0, psnr = 0;
+};
+
+inline ImageError image_error(const Film& img, const Film& ref) {
+    ImageError e;
+    if (img.W != ref.W || img.H != ref.H || img.sum.empty()) return e;
+    auto disp = [](double x){ return std::min(1.0, std::pow(std::max(0.0, x), 1.0/2.2)); };
+    double se = 0, rel = 0, dse = 0;
+    for (int j = 0; j < img.H; ++j)
+        for (int i = 0; i < img.W; ++i) {
+            Color a = img.mean(i, j), b = ref.mean(i, j);
+            double xa[3] = {a.r, a.g, a.b}, xb[3] = {b.r, b.g, b.b};
+            for (int c = 0; c < 3; ++c) {
+                double d = xa[c] - xb[c];
+                se  += d*d;
+                rel += d*d / (xb[c]*xb[c] + 1e-2);  // epsilon keeps black pixels finite
+                double dd = disp(xa[c]) - disp(xb[c]);
+                dse += dd*dd;
+            }
+        }
+    double n = 3.0 * img.W * img.H;
+    e.rmse = std::sqrt(se / n);
+    e.relmse = rel / n;
+    e.psnr = dse > 0 ? 10.0 * std::log10(n / dse) : std::numeric_limits<double>::infinity();
+    return e;
+}
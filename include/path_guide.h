@@ -0,0 +1,200 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "vec3.h"
+#include "sampler.h"
+
+// Path guiding with a spatial-directional tree (SD-tree, Müller et al. 2017).
+//
+// Space is a binary tree over the scene bounds (splits at the midpoint, cycling
+// x, y, z). Each spatial leaf holds two quadtrees over directions, parametrised as
+// (cos theta, phi) in [0,1]^2, which is area preserving (4 pi sr per unit area):
+//   sampling - the incident radiance learned in earlier passes, read-only while rendering
+//   training - collects this pass' radiance estimates Li/pdf from all render threads
+// end_pass() turns the training trees into the new sampling trees, splits spatial
+// leaves that received many records and refines each quadtree where it holds more
+// than rho of the energy. Call it between progressive passes; recording is lock-free
+// (atomic adds) and the tree structure only changes inside end_pass().
+
+// double accumulator that can live in a std::vector
+struct AtomicSum {
+    std::atomic<double> v{0.0};
+    AtomicSum() = default;
+    AtomicSum(const AtomicSum& o) : v(o.get()) {}
+    AtomicSum& operator=(const AtomicSum& o) { v.store(o.get(), std::memory_order_relaxed); return *this; }
+    double get() const { return v.load(std::memory_order_relaxed); }
+    void add(double x) {
+        double cur = get();
+        while (!v.compare_exchange_weak(cur, cur + x, std::memory_order_relaxed)) {}
+    }
+};
+
+struct GuideQuad {
+    std::vector<int> child{0};                  // first of 4 children, 0 = leaf; root is node 0
+    std::vector<AtomicSum> sum = std::vector<AtomicSum>(1);
+
+    bool valid() const { return sum[0].get() > 0; }
+
+    static void to_square(const Vec3& d, double& u, double& v) {
+        u = std::clamp(0.5 * (d.z + 1.0), 0.0, 1.0 - 1e-12);
+        v = std::atan2(d.y, d.x) * (0.5 / 3.14159265358979323846);
+        if (v < 0) v += 1.0;
+        v = std::min(v, 1.0 - 1e-12);
+    }
+    static Vec3 from_square(double u, double v) {
+        double z = 2.0*u - 1.0, s = std::sqrt(std::max(0.0, 1.0 - z*z)), phi = 2.0*3.14159265358979323846*v;
+        return Vec3(s*std::cos(phi), s*std::sin(phi), z);
+    }
+    static int quadrant(double& u, double& v) {
+        int q = (u >= 0.5) + 2*(v >= 0.5);
+        u = 2*u - (u >= 0.5); v = 2*v - (v >= 0.5);
+        return q;
+    }
+
+    void add(const Vec3& d, double x) {
+        double u, v; to_square(d, u, v);
+        int k = 0;
+        while (child[k]) k = child[k] + quadrant(u, v);
+        sum[k].add(x);
+    }
+
+    // pdf per steradian of sample()
+    double pdf(const Vec3& d) const {
+        if (!valid()) return 0.0;
+        double u, v; to_square(d, u, v);
+        double p = 1.0;
+        for (int k = 0; child[k]; ) {
+            int c = child[k] + quadrant(u, v);
+            p *= 4.0 * sum[c].get() / sum[k].get();
+            if (p <= 0) return 0.0;
+            k = c;
+        }
+        return p / (4.0*3.14159265358979323846);
+    }
+
+    // direction proportional to the stored energy; requires valid()
+    template <class Rng>
+    Vec3 sample(Rng& rng) const {
+        double ox = 0, oy = 0, size = 1;
+        for (int k = 0; child[k]; ) {
+            double x = next_1d(rng) * sum[k].get();
+            int q = 0;
+            while (q < 3 && x >= sum[child[k] + q].get()) x -= sum[child[k] + q++].get();
+            size *= 0.5;
+            ox += size * (q & 1); oy += size * (q >> 1);
+            k = child[k] + q;
+        }
+        Sample2 r = next_2d(rng);
+        return from_square(ox + size*r.u, oy + size*r.v);
+    }
+
+    // leaf sums -> interior nodes
+    void propagate() {
+        for (int k = (int)child.size() - 1; k >= 0; --k)
+            if (child[k]) {
+                double s = 0;
+                for (int q = 0; q < 4; ++q) s += sum[child[k] + q].get();
+                sum[k].v.store(s, std::memory_order_relaxed);
+            }
+    }
+
+    // empty tree refined where src holds more than rho of its energy
+    void refine_from(const GuideQuad& src, double rho, int maxDepth) {
+        child.assign(1, 0);
+        sum.assign(1, AtomicSum());
+        double total = src.sum[0].get();
+        if (!(total > 0)) return;
+        struct Item { int dst, src, depth; double e; };
+        std::vector<Item> stack{ {0, 0, 0, total} };
+        while (!stack.empty()) {
+            Item it = stack.back(); stack.pop_back();
+            if (it.depth >= maxDepth || it.e <= rho * total) continue;
+            int first = (int)child.size();
+            child[it.dst] = first;
+            child.resize(first + 4, 0);
+            sum.resize(first + 4);
+            for (int q = 0; q < 4; ++q) {
+                int s = (it.src >= 0 && src.child[it.src]) ? src.child[it.src] + q : -1;
+                stack.push_back({ first + q, s, it.depth + 1, s >= 0 ? src.sum[s].get() : 0.25 * it.e });
+            }
+        }
+    }
+};
+
+struct PathGuide {
+    struct Leaf { GuideQuad sampling, training; AtomicSum records; };
+
+    bool training = true;       // record radiance while rendering
+    double alpha = 0.5;         // probability of sampling the guide instead of the cosine lobe
+    double splitRecords = 4000; // spatial split threshold (times sqrt(2^pass))
+    double rho = 0.01;          // quadtree refinement threshold (fraction of a leaf's energy)
+    int maxQuadDepth = 16, maxSpatialDepth = 24;
+
+    // lo/hi: scene bounds (SceneT::bounds)
+    PathGuide(const Vec3& lo, const Vec3& hi)
+        : lo(lo - margin(lo, hi)), hi(hi + margin(lo, hi)), nodes(1), leaves(1) {}
+
+    int passes() const { return pass; }
+    int leaf_count() const { return (int)leaves.size(); }
+
+    Leaf& leaf(const Vec3& p) {
+        Vec3 a = lo, b = hi;
+        int k = 0;
+        while (nodes[k].child >= 0) {
+            int ax = nodes[k].axis;
+            double mid = 0.5 * (comp(a, ax) + comp(b, ax));
+            if (comp(p, ax) < mid) { comp(b, ax) = mid; k = nodes[k].child; }
+            else                   { comp(a, ax) = mid; k = nodes[k].child + 1; }
+        }
+        return leaves[nodes[k].leaf];
+    }
+
+    // one radiance estimate (luminance of Li / pdf of the sampled direction d)
+    void record(Leaf& l, const Vec3& d, double value) {
+        if (!(value >= 0) || std::isinf(value)) return;
+        l.training.add(d, value);
+        l.records.add(1.0);
+    }
+
+    // single-threaded: learn from the pass just rendered and prepare the next one
+    void end_pass() {
+        for (auto& l : leaves) {
+            l.training.propagate();
+            if (l.training.valid()) l.sampling = l.training;
+        }
+        double threshold = splitRecords * std::sqrt(std::pow(2.0, pass));
+        for (int k = 0, n = (int)nodes.size(); k < n; ++k) split(k, leaves[nodes[k].leaf].records.get(), threshold);
+        for (auto& l : leaves) {
+            l.training.refine_from(l.sampling, rho, maxQuadDepth);
+            l.records = AtomicSum();
+        }
+        ++pass;
+    }
+
+private:
+    struct Node { int child = -1, axis = 0, leaf = 0, depth = 0; };   // children child, child+1
+
+    Vec3 lo, hi;
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+    int pass = 0;
+
+    // small margin so hit points on the bounds still land inside
+    static Vec3 margin(const Vec3& lo, const Vec3& hi) { return (hi - lo) * 1e-3 + Vec3(1e-4, 1e-4, 1e-4); }
+    static double& comp(Vec3& v, int ax) { return ax == 0 ? v.x : ax == 1 ? v.y : v.z; }
+    static double comp(const Vec3& v, int ax) { return ax == 0 ? v.x : ax == 1 ? v.y : v.z; }
+
+    // split leaf node k while its (halved per level) record count exceeds threshold
+    void split(int k, double records, double threshold) {
+        if (nodes[k].child >= 0 || records <= threshold || nodes[k].depth >= maxSpatialDepth) return;
+        int first = (int)nodes.size(), ax = (nodes[k].axis + 1) % 3, l = nodes[k].leaf, d = nodes[k].depth + 1;
+        nodes[k].child = first;
+        leaves.push_back(leaves[l]);
+        nodes.push_back({ -1, ax, l, d });
+        nodes.push_back({ -1, ax, (int)leaves.size() - 1, d });
+        split(first, records / 2, threshold);
+        split(first + 1, records / 2, threshold);
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Batched visibility queries against the renderer's scene engine, for use from
+// other programs (sensor coverage, light-meter checks, ...).
+//
+// This header is the whole public API: it pulls in none of the renderer headers,
+// so the implementation (src/ray_query.cpp) can change without breaking callers.
+// Build it as a library with e.g.
+//   g++ -std=c++17 -O2 -fPIC -Iinclude -c src/ray_query.cpp -o ray_query.o
+//   ar rcs libraytracer_query.a ray_query.o        (or g++ -shared ... -o libraytracer_query.so)
+// and link with -pthread.
+//
+// Batch calls fill caller-owned buffers, split the rays over an internal thread
+// pool and do not allocate. Calls on one RayQueryScene are serialised; use one
+// object per calling thread for concurrent batches.
+
+struct QueryRay {
+    double ox, oy, oz;      // origin
+    double dx, dy, dz;      // direction, need not be unit
+    double tmin, tmax;      // distance range along the normalised direction
+};
+
+struct QueryHit {
+    double t;               // distance to the hit (along the normalised direction)
+    double px, py, pz;      // hit point
+    double nx, ny, nz;      // unit normal, facing the ray origin
+    int32_t prim;           // id returned by add_*, or -1 for a miss
+    int32_t front;          // 1 if the ray hit the outward side of the primitive
+};
+
+class RayQueryScene {
+public:
+    explicit RayQueryScene(int threads = 0);    // 0 = one per hardware thread
+    ~RayQueryScene();
+    RayQueryScene(RayQueryScene&&) noexcept;
+    RayQueryScene& operator=(RayQueryScene&&) noexcept;
+
+    // geometry; each call returns the new primitive's id (0, 1, 2, ... in call order)
+    int add_triangle(const double a[3], const double b[3], const double c[3]);
+    int add_rectangle(const double corner[3], const double e1[3], const double e2[3]);
+    int add_sphere(const double center[3], double radius);
+
+    // appends one of the renderer's named scenes ("room", "room_empty"); false if unknown
+    bool add_named(const char* id);
+
+    int primitive_count() const;
+    int threads() const;
+
+    // nearest hit per ray -> hits[i]
+    void closest_hit(const QueryRay* rays, QueryHit* hits, size_t n) const;
+    // occluded[i] = 1 if anything lies on ray i within [tmin, tmax], else 0
+    void any_hit(const QueryRay* rays, uint8_t* occluded, size_t n) const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
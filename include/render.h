@@ -0,0 +1,195 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "camera.h"
+#include "scene.h"
+#include "bdpt.h"
+#include "sampler.h"
+#include "split_rr.h"
+#include "film.h"
+#include "thread_pool.h"
+
+enum class Integrator { PATH, MIS, BDPT };
+
+inline bool parse_integrator(const char* s, Integrator& out) {
+    if (!std::strcmp(s, "path")) { out = Integrator::PATH; return true; }
+    if (!std::strcmp(s, "mis"))  { out = Integrator::MIS;  return true; }
+    if (!std::strcmp(s, "bdpt")) { out = Integrator::BDPT; return true; }
+    return false;
+}
+
+struct RenderParams {
+    int ls = 10;          // light samples per diffuse hit
+    int depth = 20;       // max path depth
+    uint64_t seed = 1;
+    double clamp = 10.0;  // firefly clamp on max channel (<=0 disables)
+    Integrator integrator = Integrator::PATH;
+    PathGuide* guide = nullptr;  // path guiding for the PATH integrator (path_guide.h)
+    SamplerType sampler = SamplerType::RANDOM;   // see sampler.h
+    int spp = 0;          // planned samples per pixel, sizes the ZSOBOL index (0: s1 of each call)
+    const SplitRR* split = nullptr;   // splitting and roulette for the PATH integrator (split_rr.h), no guide
+    const std::vector<BdEmitter>* emitters = nullptr;   // BDPT's emitter list, see with_emitters
+};
+
+// p with BDPT's emitter list built once into em, so samples do not rescan the scene;
+// p unchanged for the other integrators or when it already has a list
+template <class SceneType>
+inline RenderParams with_emitters(const SceneType& scene, const RenderParams& p, std::vector<BdEmitter>& em) {
+    if (p.integrator != Integrator::BDPT || p.emitters) return p;
+    em = bdpt_detail::scene_emitters(scene);
+    RenderParams q = p;
+    q.emitters = &em;
+    return q;
+}
+
+// radiance along one camera ray with the selected integrator
+template <class SceneType, class Rng>
+inline Color radiance(const SceneType& scene, const Ray& r, const RenderParams& p, Rng& rng) {
+    switch (p.integrator) {
+        case Integrator::MIS:  return scene.shade_path_mis(r, p.depth, p.ls, rng);
+        case Integrator::BDPT:   // ls unused
+            if (p.emitters) return BDPT<SceneType>(scene, p.depth, *p.emitters).radiance(r, rng);
+            return bdpt_radiance(scene, r, p.depth, rng);
+        default:
+            if (p.split) return shade_path_split(scene, r, p.depth, p.ls, rng, *p.split);
+            return scene.shade_path(r, p.depth, p.ls, rng, nullptr, p.guide);
+    }
+}
+
+// one camera sample through pixel (i, j): jitter, shade(ray, rng), firefly clamp
+template <class Shade, class Rng>
+inline Color camera_sample(const Camera& cam, int i, int j, int W, int H,
+                           const RenderParams& p, Shade& shade, Rng& rng) {
+    Sample2 jit = next_2d(rng);
+    Color c = shade(cam.get_ray((i + jit.u) / (W - 1), (j + jit.v) / (H - 1)), rng);
+    double m = std::max({c.r,c.g,c.b});
+    if (p.clamp > 0 && m > p.clamp) c = c * (p.clamp/m);
+    return c;
+}
+
+// Add samples [s0, s1) to row j of the film, each camera ray shaded by
+// shade(const Ray&, Rng&) -> Color (a generic lambda: Rng is one of the samplers).
+// With the RANDOM sampler each (row, s0) pair gets its own RNG stream, so
+// progressive calls continue the estimate instead of repeating it; the QMC
+// samplers index their sequence by sample number.
+template <class Shade>
+inline void render_row_with(const Camera& cam, Film& film, int j, int s0, int s1,
+                            const RenderParams& p, Shade& shade) {
+    const int W = film.W, H = film.H;
+    const int spp = p.spp > 0 ? p.spp : s1;
+    std::mt19937_64 rng(mix_seed(p.seed ^ mix_seed((uint64_t(j) << 32) | uint32_t(s0))));
+    for (int i = 0; i < W; ++i){
+        Color acc(0,0,0);
+        for (int s = s0; s < s1; ++s){
+            if (p.sampler == SamplerType::SOBOL) {
+                SobolSampler qs(i, j, uint32_t(s), p.seed);
+                acc = acc + camera_sample(cam, i, j, W, H, p, shade, qs);
+            } else if (p.sampler == SamplerType::ZSOBOL) {
+                ZSobolSampler qs(i, j, uint32_t(s), p.seed, W, H, spp);
+                acc = acc + camera_sample(cam, i, j, W, H, p, shade, qs);
+            } else {
+                acc = acc + camera_sample(cam, i, j, W, H, p, shade, rng);
+            }
+        }
+        film.at(i, j) = film.at(i, j) + acc;
+    }
+}
+
+// render_row_with for rows [j0, j1), one row per pool task
+template <class Shade>
+inline void render_rows_with(ThreadPool& pool, const Camera& cam, Film& film, int j0, int j1,
+                             int s0, int s1, const RenderParams& p, Shade shade) {
+    if (s1 <= s0 || j1 <= j0) return;
+    pool.parallel_for(j1 - j0, [&](int jj, int){ render_row_with(cam, film, j0 + jj, s0, s1, p, shade); });
+}
+
+// render_rows_with the selected integrator
+template <class SceneType>
+inline void render_rows(ThreadPool& pool, const SceneType& scene, const Camera& cam,
+                        Film& film, int j0, int j1, int s0, int s1, const RenderParams& p) {
+    std::vector<BdEmitter> em;
+    RenderParams rp = with_emitters(scene, p, em);
+    render_rows_with(pool, cam, film, j0, j1, s0, s1, rp,
+                     [&](const Ray& r, auto& rng){ return radiance(scene, r, rp, rng); });
+}
+
+// Add samples [s0, s1) to every pixel of the film.
+template <class SceneType>
+inline void render_samples(ThreadPool& pool, const SceneType& scene, const Camera& cam,
+                           Film& film, int s0, int s1, const RenderParams& p) {
+    if (s1 <= s0) return;
+    render_rows(pool, scene, cam, film, 0, film.H, s0, s1, p);
+    film.samples += s1 - s0;
+}
+
+// Render spp samples per pixel, one pool task per row from the top of the image
+// down, and hand each row to sink.push_row(const Color*) (see image_stream.h) in
+// order as soon as it and all rows above it are done. Workers never wait for each
+// other; rows that finish early are held until the rows above them arrive, so
+// memory stays around a few rows per thread. progress(rowsDone) follows every
+// handed-over run of rows. sink and progress are called from the pool's threads,
+// one call at a time. Camera rays are shaded as in render_row_with.
+template <class Sink, class Progress, class Shade>
+inline void render_streamed_with(ThreadPool& pool, const Camera& cam, int spp, const RenderParams& p,
+                                 Sink& sink, Progress progress, Shade shade) {
+    const int W = sink.width(), H = sink.height();
+    std::vector<std::vector<Color>> ready(H);   // finished rows waiting for the rows above
+    std::mutex m;
+    int next = 0;                               // next image row for sink
+    pool.parallel_for(H, [&](int y, int){
+        Film film(W, H, H-1-y, 1);              // image row y is film row H-1-y
+        render_row_with(cam, film, H-1-y, 0, spp, p, shade);
+        film.samples = spp;
+        for (int i = 0; i < W; ++i) film.sum[i] = film.mean(i, H-1-y);
+        std::lock_guard<std::mutex> lk(m);
+        ready[y] = std::move(film.sum);
+        int first = next;
+        for (; next < H && !ready[next].empty(); ++next) {
+            sink.push_row(ready[next].data());
+            std::vector<Color>().swap(ready[next]);
+        }
+        if (next > first) progress(next);
+    });
+}
+
+// render_streamed_with the selected integrator
+template <class SceneType, class Sink, class Progress>
+inline void render_streamed(ThreadPool& pool, const SceneType& scene, const Camera& cam, int spp,
+                            const RenderParams& p, Sink& sink, Progress progress) {
+    std::vector<BdEmitter> em;
+    RenderParams rp = with_emitters(scene, p, em);
+    render_streamed_with(pool, cam, spp, rp, sink, progress,
+                         [&](const Ray& r, auto& rng){ return radiance(scene, r, rp, rng); });
+}
+
+// Tune s for rendering scene through cam at W x H with p (PATH integrator). Each
+// candidate renders two independent pilot images at a quarter of the resolution with
+// 4 spp; half their mean squared luminance difference times spp is the per-sample
+// variance, and it is weighted by the measured time per sample. All candidates use
+// the same seeds. About 10 candidates, costing roughly 5 spp of the full image.
+template <class SceneType>
+inline void tune_split_rr(ThreadPool& pool, const SceneType& scene, const Camera& cam,
+                          int W, int H, const RenderParams& p, SplitRR& s) {
+    const int w = std::max(8, W / 4), h = std::max(8, H / 4), spp = 4;
+    RenderParams rp = p;
+    rp.integrator = Integrator::PATH; rp.guide = nullptr; rp.spp = spp;
+    auto lum = [](const Color& c){ return 0.2126*c.r + 0.7152*c.g + 0.0722*c.b; };
+    s.tune([&](const SplitRR& c){
+        rp.split = &c;
+        Film a(w, h), b(w, h);
+        auto t0 = std::chrono::steady_clock::now();
+        rp.seed = mix_seed(p.seed ^ 0x5b11);      render_samples(pool, scene, cam, a, 0, spp, rp);
+        rp.seed = mix_seed(p.seed ^ 0x5b11 ^ 1);  render_samples(pool, scene, cam, b, 0, spp, rp);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        double d2 = 0;
+        for (int j = 0; j < h; ++j)
+            for (int i = 0; i < w; ++i) { double d = lum(a.mean(i, j)) - lum(b.mean(i, j)); d2 += d*d; }
+        double variance = 0.5 * spp * d2 / (double(w) * h);
+        return variance * sec / (2.0 * spp * w * h);
+    });
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "camera.h"
+#include "render.h"
+#include "image_stream.h"
+#include "thread_pool.h"
+
+// Shared main() of the rt* render tools: command line, thread pool, multithreaded
+// rendering streamed to the output file, progress with ETA.
+//
+//   --w 400 [--h 0] [--ar 1] --spp 20 --ls 10 --d 20 --seed 1 --threads 0 --out image.ppm
+//   [--integrator path|mis|bdpt] [--sampler random|sobol|zsobol] [--clamp 10] [--quiet 0]
+//   [--split-rr 0]
+//
+// A tool fills DriverOptions with its own defaults, lets parse_driver_args override
+// them and calls render_scene (the integrators of render.h) or render_shaded (any
+// per-ray shader). --h 0 derives the height from --ar; --seed 0 picks a time-based
+// seed; --threads 0 uses every core. The output format follows the file extension
+// (.ppm, .png, .qoi, .pfm; see image_stream.h). --split-rr 1 tunes path splitting
+// and roulette for the scene before rendering (path integrator, split_rr.h).
+struct DriverOptions {
+    int w = 400, h = 0;
+    double aspect = 1.0;        // width / height when h == 0
+    int spp = 20;
+    int threads = 0;
+    RenderParams p;
+    std::string out = "image.ppm";
+    bool quiet = false;         // no progress line
+    bool splitRR = false;       // tune split_rr.h for the path integrator
+};
+
+// value following flag 'name' on the command line, or def; shared by all rt_* tools
+inline int argi(const char* name, int def, int argc, char** argv){
+    for (int k=1; k<argc-1; ++k) if (!std::strcmp(argv[k], name)) return std::atoi(argv[k+1]);
+    return def;
+}
+inline double argd(const char* name, double def, int argc, char** argv){
+    for (int k=1; k<argc-1; ++k) if (!std::strcmp(argv[k], name)) return std::atof(argv[k+1]);
+    return def;
+}
+inline const char* args(const char* name, const char* def, int argc, char** argv){
+    for (int k=1; k<argc-1; ++k) if (!std::strcmp(argv[k], name)) return argv[k+1];
+    return def;
+}
+// 64-bit unsigned flag (seeds): out is left alone if the flag is absent; false if
+// the value is not a plain decimal in range (no sign, no overflow, no trailing text)
+inline bool argu64(const char* name, uint64_t& out, int argc, char** argv){
+    const char* v = args(name, nullptr, argc, argv);
+    if (!v) return true;
+    if (*v < '0' || *v > '9') return false;
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long x = std::strtoull(v, &end, 10);
+    if (errno == ERANGE || *end) return false;
+    out = x;
+    return true;
+}
+
+namespace driver_detail {
+
+inline void usage(const char* tool, const DriverOptions& o) {
+    std::cerr << "usage: " << tool << " [--w " << o.w << "] [--h " << o.h << "] [--ar " << o.aspect
+              << "] [--spp " << o.spp << "] [--ls " << o.p.ls << "] [--d " << o.p.depth
+              << "] [--seed " << o.p.seed << "] [--threads " << o.threads << "] [--out " << o.out << "]\n"
+              << "       [--integrator path|mis|bdpt] [--sampler random|sobol|zsobol] [--clamp "
+              << o.p.clamp << "] [--quiet 0] [--split-rr 0]\n";
+}
+
+} // namespace driver_detail
+
+// override o from the command line; false (after printing usage) on bad values
+inline bool parse_driver_args(int argc, char** argv, DriverOptions& o) {
+    DriverOptions def = o;
+    o.w         = argi("--w", o.w, argc, argv);
+    o.h         = argi("--h", o.h, argc, argv);
+    o.aspect    = argd("--ar", o.aspect, argc, argv);
+    o.spp       = argi("--spp", o.spp, argc, argv);
+    o.p.ls      = argi("--ls", o.p.ls, argc, argv);
+    o.p.depth   = argi("--d", o.p.depth, argc, argv);
+    o.threads   = argi("--threads", o.threads, argc, argv);
+    if (const char* v = args("--out", nullptr, argc, argv)) o.out = v;
+    o.p.clamp   = argd("--clamp", o.p.clamp, argc, argv);
+    o.quiet     = argi("--quiet", o.quiet, argc, argv) != 0;
+    o.splitRR   = argi("--split-rr", o.splitRR, argc, argv) != 0;
+    bool ok = argu64("--seed", o.p.seed, argc, argv);
+    if (const char* v = args("--integrator", nullptr, argc, argv)) ok = ok && parse_integrator(v, o.p.integrator);
+    if (const char* v = args("--sampler", nullptr, argc, argv))    ok = ok && parse_sampler(v, o.p.sampler);
+    if (o.h <= 0 && o.aspect > 0) o.h = int(o.w / o.aspect + 0.5);
+    if (o.p.seed == 0) o.p.seed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    o.p.spp = o.spp;
+    ok = ok && o.w > 1 && o.h > 1 && o.spp > 0 && (!o.splitRR || o.p.integrator == Integrator::PATH);
+    if (!ok) driver_detail::usage(argc > 0 ? argv[0] : "rt", def);
+    return ok;
+}
+
+// Render o.w x o.h with shade(const Ray&, Rng&) -> Color (generic lambda, see
+// render_row_with) and write o.out; true if the image was written completely.
+template <class Shade>
+inline bool render_shaded(const DriverOptions& o, ThreadPool& pool, const Camera& cam, Shade shade) {
+    std::cout << "w="<<o.w<<" h="<<o.h<<" spp="<<o.spp<<" ls="<<o.p.ls<<" depth="<<o.p.depth
+              << " seed="<<o.p.seed<<" threads="<<pool.size()<<" out="<<o.out<<"\n";
+
+    // rows are encoded and written while the rest of the image renders
+    ImageStream out(o.out, o.w, o.h);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]{ return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    render_streamed_with(pool, cam, o.spp, o.p, out, [&](int done){
+        if (o.quiet) return;
+        double progress = double(done) / o.h, sec = elapsed();
+        double eta = sec * (1.0 / progress - 1.0);
+        std::cerr << "\rRendering: " << int(progress * 100) << "% | elapsed " << int(sec) << "s | ETA ";
+        if (eta > 60) std::cerr << int(eta / 60) << " min   " << std::flush;
+        else          std::cerr << int(eta) << "s   " << std::flush;
+    }, shade);
+    bool ok = out.finish();
+    if (!o.quiet) std::cerr << "\n";
+    std::cerr << "Render finished in " << elapsed() << " s\n";
+    if (!ok) std::cerr << "could not write " << o.out << "\n";
+    return ok;
+}
+
+// render_shaded on a pool of o.threads workers
+template <class Shade>
+inline bool render_shaded(const DriverOptions& o, const Camera& cam, Shade shade) {
+    ThreadPool pool(o.threads);
+    return render_shaded(o, pool, cam, shade);
+}
+
+// render_shaded with the integrator selected in o.p
+template <class SceneType>
+inline bool render_scene(const DriverOptions& o, const SceneType& scene, const Camera& cam = Camera()) {
+    std::vector<BdEmitter> em;
+    RenderParams p = with_emitters(scene, o.p, em);
+    SplitRR srr;
+    ThreadPool pool(o.threads);
+    if (o.splitRR) {
+        tune_split_rr(pool, scene, cam, o.w, o.h, p, srr);
+        p.split = &srr;
+        std::cout << "split-rr: split " << srr.split << ", threshold " << srr.threshold << "\n";
+    }
+    return render_shaded(o, pool, cam, [&](const Ray& r, auto& rng){ return radiance(scene, r, p, rng); });
+}
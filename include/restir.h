@@ -0,0 +1,306 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "camera.h"
+#include "scene.h"
+#include "bdpt.h"
+#include "film.h"
+#include "render.h"
+#include "sampler.h"
+#include "thread_pool.h"
+
+// Reservoir-based resampled direct lighting (ReSTIR DI, Bitterli et al. 2020) for
+// the path integrator's first diffuse hit.
+//
+// Every pass (one sample per pixel) runs four screen-space steps:
+//   1. follow the camera ray through mirrors to the first diffuse hit, estimate the
+//      indirect light there with shade_path, and stream 'candidates' light points
+//      into the pixel's reservoir (resampled importance sampling). A candidate only
+//      costs an evaluation of the target, its unshadowed contribution; the survivor
+//      gets one shadow ray and is dropped if occluded.
+//   2. temporal reuse: merge the reservoir the pixel ended the previous pass with,
+//      its sample count capped at temporalCap times the candidate count.
+//   3. spatial reuse: merge 'neighbours' random reservoirs within 'radius' pixels
+//      whose surface is similar (normal and distance).
+//   4. shade with the surviving light point: one more shadow ray.
+// Reservoirs hold a point on an emitter, so reusing one at another surface only needs
+// the target re-evaluated there. The normalisation counts only reservoirs whose
+// surface could have produced the chosen point: nonzero target and, because step 1
+// drops occluded survivors, the point visible from that surface. A point is known
+// visible from the surface it came from, so each merge traces a shadow ray only for
+// the other merged reservoirs: at most 1 + 1 + neighbours rays per pixel and pass
+// (steps 1, 2, 3; step 4 reuses the last test), 5 with the defaults and about 1.7 on
+// average in the hex room. With 'unbiased' off the visibility tests are skipped: at
+// most 2 rays (steps 1 and 4), about 1.4 in the hex room, but reuse next to shadow
+// boundaries then comes out slightly dark (about 0.5% there).
+//
+// Emitters are the ones BDPT uses (emissive RectGeom/Sphere and the RectLights),
+// picked by power. Direct light at the first diffuse hit comes only from the
+// reservoir, so the indirect ray from there ignores emitters it lands on; deeper
+// vertices, and a diffuse hit with no bounce left, are shaded as in shade_path.
+// The reservoirs carry over between calls: keep one RestirDI per camera and image
+// size for a progressive render.
+struct RestirDI {
+    int candidates = 32;        // light candidates per pixel and pass (no shadow rays)
+    int neighbours = 3;         // reservoirs merged by spatial reuse
+    double radius = 16;         // spatial reuse radius in pixels
+    double temporalCap = 20;    // cap on the previous pass' M, in units of candidates
+    bool temporal = true, spatial = true;
+    bool unbiased = true;       // visibility in the reuse normalisation (shadow rays)
+
+    struct Reservoir {
+        Vec3 y, ny; Color Le;       // light point, emitting normal, radiance
+        double wsum = 0, M = 0, W = 0;
+    };
+    struct Surface {
+        Vec3 p, n; Color albedo;
+        double t = 0;               // camera distance (through mirrors)
+        bool valid = false;         // false: no diffuse hit, nothing to resample
+    };
+
+    int W = 0, H = 0;
+    std::vector<Surface> surf, prevSurf;          // j*W + i, j = film row
+    std::vector<Reservoir> res, prevRes, scratch;
+    std::vector<Color> rest;                      // sample radiance without the reservoir's light
+};
+
+namespace restir_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+inline double lum(const Color& c) { return 0.2126*c.r + 0.7152*c.g + 0.0722*c.b; }
+
+// unshadowed direct light from point y (normal ny, radiance Le) reflected at s
+inline Color contribution(const RestirDI::Surface& s, const Vec3& y, const Vec3& ny, const Color& Le) {
+    Vec3 d = y - s.p;
+    double d2 = dot(d, d);
+    if (!(d2 > 0)) return Color(0,0,0);
+    Vec3 wi = d / std::sqrt(d2);
+    double cosx = dot(s.n, wi), cosy = -dot(ny, wi);
+    if (cosx <= 0 || cosy <= 0) return Color(0,0,0);
+    double g = cosx*cosy / (kPi*d2);
+    return Color(s.albedo.r*Le.r*g, s.albedo.g*Le.g*g, s.albedo.b*Le.b*g);
+}
+inline double target(const RestirDI::Surface& s, const RestirDI::Reservoir& r) {
+    return lum(contribution(s, r.y, r.ny, r.Le));
+}
+
+inline bool similar(const RestirDI::Surface& a, const RestirDI::Surface& b) {
+    return a.valid && b.valid && dot(a.n, b.n) > 0.9 && std::fabs(a.t - b.t) <= 0.1 * a.t;
+}
+
+// stream light point s with resampling weight w and sample count M into out; it
+// replaces out's point with probability w / wsum (returns true if it did)
+inline bool stream(RestirDI::Reservoir& out, const RestirDI::Reservoir& s, double w, double M, double u) {
+    out.wsum += w; out.M += M;
+    if (!(w > 0 && u * out.wsum < w)) return false;
+    out.y = s.y; out.ny = s.ny; out.Le = s.Le;
+    return true;
+}
+
+// weight of the merged reservoir out at surface at, given the merged reservoirs'
+// surfaces (from[0] == &at) and sample counts, out's point taken from reservoir
+// 'chosen'; visible(surface, reservoir) tells whether the point is unoccluded from
+// a surface (always true: biased). A reservoir with W > 0 already has its point
+// visible from its own surface, so from[chosen] is not tested again.
+template <class Visible>
+inline void finish(RestirDI::Reservoir& out, const RestirDI::Surface& at,
+                   const RestirDI::Surface* const* from, const double* M, int n, int chosen, Visible visible) {
+    double t = out.wsum > 0 ? target(at, out) : 0.0;
+    if (t > 0 && from[chosen] != &at && !visible(at, out)) t = 0;
+    double Z = 0;
+    for (int k = 0; k < n && t > 0; ++k)
+        if (k == chosen || from[k] == &at || (M[k] > 0 && target(*from[k], out) > 0 && visible(*from[k], out))) Z += M[k];
+    out.W = (t > 0 && Z > 0) ? out.wsum / (Z * t) : 0.0;
+}
+
+template <class SceneType, size_t... I>
+bool is_emitter_kind(int kind, std::index_sequence<I...>) {
+    return ((kind == int(I) && is_emitter_prim<typename std::tuple_element_t<I, decltype(SceneType::geom)>::value_type>::value) || ...);
+}
+
+} // namespace restir_detail
+
+// Add samples [s0, s1) to the film with the PATH integrator, the first diffuse hit's
+// direct light resampled from st's reservoirs. p.integrator and p.guide are not
+// used; ls still sets the light samples at deeper vertices. The reservoirs draw from
+// per-pixel pseudo-random streams, so a QMC p.sampler is refused: false, nothing added.
+template <class SceneType>
+inline bool restir_samples(ThreadPool& pool, const SceneType& scene, const Camera& cam, Film& film,
+                           int s0, int s1, const RenderParams& p, RestirDI& st) {
+    using namespace restir_detail;
+    using Surface = RestirDI::Surface;
+    using Reservoir = RestirDI::Reservoir;
+    if (p.sampler != SamplerType::RANDOM) return false;
+    if (s1 <= s0) return true;
+    const int W = film.W, H = film.H;
+    const size_t N = size_t(W) * H;
+    if (st.W != W || st.H != H) {
+        st.W = W; st.H = H;
+        st.surf.assign(N, {}); st.prevSurf.assign(N, {});
+        st.res.assign(N, {}); st.prevRes.assign(N, {}); st.scratch.assign(N, {});
+        st.rest.assign(N, Color(0,0,0));
+    }
+
+    // power CDF over the emitters
+    std::vector<BdEmitter> em = bdpt_detail::scene_emitters(scene);
+    std::vector<double> cdf;
+    double acc = 0;
+    for (const auto& e : em) cdf.push_back(acc += e.pick);
+    auto light_point = [&](Reservoir& r, std::mt19937_64& rng) -> double {
+        double x = next_1d(rng) * acc;
+        size_t k = std::min(em.size() - 1, size_t(std::upper_bound(cdf.begin(), cdf.end(), x) - cdf.begin()));
+        const BdEmitter& e = em[k];
+        if (e.pick <= 0 || e.area <= 0) return 0.0;
+        Sample2 u = next_2d(rng);
+        if (e.prim < 0) { r.y = scene.lights[e.index].sample(u.u, u.v); r.ny = scene.lights[e.index].normal; }
+        else r.y = bdpt_detail::emitter_point(scene, e, u.u, u.v, r.ny,
+                       std::make_index_sequence<std::tuple_size_v<decltype(scene.geom)>>{});
+        r.Le = e.Le;
+        return e.pick / e.area;     // area density of the point
+    };
+    auto row_rng = [&](int j, int s, uint64_t step) {
+        return std::mt19937_64(mix_seed(p.seed ^ mix_seed((uint64_t(j) << 32) | uint32_t(s)) ^ step));
+    };
+    auto shadowed = [&](const Surface& s, const Reservoir& r) {
+        Vec3 d = r.y - s.p;
+        double d1 = length(d);
+        return scene.occluded(s.p, d / d1, d1 - 1e-3);
+    };
+    auto visible = [&](const Surface& s, const Reservoir& r) { return !st.unbiased || !shadowed(s, r); };
+
+    for (int s = s0; s < s1; ++s) {
+        // 1. primary hits, everything but the first diffuse hit's direct light, initial reservoirs
+        pool.parallel_for(H, [&](int j, int){
+            std::mt19937_64 rng = row_rng(j, s, 0);
+            for (int i = 0; i < W; ++i) {
+                size_t k = size_t(j) * W + i;
+                Surface& sf = st.surf[k];
+                Reservoir& r = st.res[k];
+                sf = Surface{}; r = Reservoir{};
+                Color L(0,0,0);
+                Sample2 jit = next_2d(rng);
+                Ray ray = cam.get_ray((i + jit.u) / (W - 1), (j + jit.v) / (H - 1));
+                for (int d = p.depth; d > 0; --d) {
+                    auto h = scene.trace_first(ray, 1e-4, 1e9);
+                    if (!h.hit) { L = scene.background(ray); break; }
+                    const Material* m = scene.material_of(h);
+                    if (!m) break;
+                    sf.t += h.rec.t;
+                    if (m->type == MatType::EMISSIVE) { if (h.rec.front_face) L = m->emission; break; }
+                    if (m->type == MatType::MIRROR) { ray = Ray(h.rec.p, reflect(ray.dir, h.rec.n)); continue; }
+                    if (d == 1) {
+                        // no bounce left, so shade_path would not reach emissive primitives
+                        L = scene.direct_light_sa(h, m->albedo, p.ls, rng);
+                        break;
+                    }
+                    sf.p = h.rec.p; sf.n = h.rec.n; sf.albedo = m->albedo; sf.valid = true;
+
+                    double ps = std::min(0.95, std::max({m->albedo.r, m->albedo.g, m->albedo.b}));
+                    if (d<=2) ps = 1.0;
+                    if (next_1d(rng) <= ps) {
+                        Ray b(h.rec.p, scene.sample_cosine_hemisphere(h.rec.n, rng));
+                        auto hb = scene.trace_first(b, 1e-4, 1e9);
+                        Color Li(0,0,0);
+                        const Material* mb = hb.hit ? scene.material_of(hb) : nullptr;
+                        if (!hb.hit) Li = scene.background(b);
+                        else if (!(mb && mb->type == MatType::EMISSIVE &&
+                                   is_emitter_kind<SceneType>(hb.kind, std::make_index_sequence<std::tuple_size_v<decltype(scene.geom)>>{})))
+                            Li = scene.shade_path_hit(b, hb, d-1, p.ls, rng);
+                        L = Color(m->albedo.r*Li.r/ps, m->albedo.g*Li.g/ps, m->albedo.b*Li.b/ps);
+                    }
+
+                    for (int c = 0; c < st.candidates && !em.empty(); ++c) {
+                        Reservoir cand;
+                        double pdf = light_point(cand, rng);
+                        double w = pdf > 0 ? target(sf, cand) / pdf : 0.0;
+                        stream(r, cand, w, 1, next_1d(rng));
+                    }
+                    double t = r.wsum > 0 ? target(sf, r) : 0.0;
+                    r.W = t > 0 ? r.wsum / (r.M * t) : 0.0;
+                    if (r.W > 0 && shadowed(sf, r)) r.W = 0;
+                    break;
+                }
+                st.rest[k] = L;
+            }
+        });
+
+        // 2. temporal reuse (camera and scene are static between passes)
+        if (st.temporal) pool.parallel_for(H, [&](int j, int){
+            std::mt19937_64 rng = row_rng(j, s, 1);
+            for (int i = 0; i < W; ++i) {
+                size_t k = size_t(j) * W + i;
+                const Surface& sf = st.surf[k];
+                if (!similar(sf, st.prevSurf[k])) continue;
+                Reservoir cur = st.res[k], out;
+                const Reservoir& prev = st.prevRes[k];
+                double M[2] = { cur.M, std::min(prev.M, st.temporalCap * st.candidates) };
+                const Surface* from[2] = { &sf, &st.prevSurf[k] };
+                int chosen = 0;
+                stream(out, cur, target(sf, cur) * cur.W * M[0], M[0], next_1d(rng));
+                if (stream(out, prev, target(sf, prev) * prev.W * M[1], M[1], next_1d(rng))) chosen = 1;
+                finish(out, sf, from, M, 2, chosen, visible);
+                st.res[k] = out;
+            }
+        });
+
+        // 3. spatial reuse, res -> scratch
+        if (st.spatial && st.neighbours > 0) {
+            pool.parallel_for(H, [&](int j, int){
+                std::mt19937_64 rng = row_rng(j, s, 2);
+                std::vector<const Surface*> from(st.neighbours + 1);
+                std::vector<double> M(st.neighbours + 1);
+                for (int i = 0; i < W; ++i) {
+                    size_t k = size_t(j) * W + i;
+                    const Surface& sf = st.surf[k];
+                    const Reservoir& cur = st.res[k];
+                    Reservoir& out = st.scratch[k];
+                    out = Reservoir{};
+                    if (!sf.valid) continue;
+                    int n = 0, chosen = 0;
+                    from[n] = &sf; M[n++] = cur.M;
+                    stream(out, cur, target(sf, cur) * cur.W * cur.M, cur.M, next_1d(rng));
+                    for (int q = 0; q < st.neighbours; ++q) {
+                        Sample2 u = next_2d(rng);
+                        double rr = st.radius * std::sqrt(u.u), phi = 2.0*kPi*u.v;
+                        int x = std::clamp(i + int(std::lround(rr * std::cos(phi))), 0, W - 1);
+                        int y = std::clamp(j + int(std::lround(rr * std::sin(phi))), 0, H - 1);
+                        size_t kq = size_t(y) * W + x;
+                        if (kq == k || !similar(sf, st.surf[kq])) continue;
+                        const Reservoir& nb = st.res[kq];
+                        from[n] = &st.surf[kq]; M[n] = nb.M;
+                        if (stream(out, nb, target(sf, nb) * nb.W * nb.M, nb.M, next_1d(rng))) chosen = n;
+                        ++n;
+                    }
+                    finish(out, sf, from.data(), M.data(), n, chosen, visible);
+                }
+            });
+            std::swap(st.res, st.scratch);
+        }
+
+        // 4. shade with the surviving light point; unbiased reuse has already tested
+        // its visibility (so has step 1 without reuse)
+        const bool tested = st.unbiased || !(st.temporal || (st.spatial && st.neighbours > 0));
+        pool.parallel_for(H, [&](int j, int){
+            for (int i = 0; i < W; ++i) {
+                size_t k = size_t(j) * W + i;
+                const Surface& sf = st.surf[k];
+                const Reservoir& r = st.res[k];
+                Color c = st.rest[k];
+                if (sf.valid && r.W > 0 && (tested || !shadowed(sf, r))) c = c + contribution(sf, r.y, r.ny, r.Le) * r.W;
+                double m = std::max({c.r,c.g,c.b});
+                if (p.clamp > 0 && m > p.clamp) c = c * (p.clamp/m);
+                film.at(i, j) = film.at(i, j) + c;
+            }
+        });
+        std::swap(st.surf, st.prevSurf);
+        std::swap(st.res, st.prevRes);
+        ++film.samples;
+    }
+    return true;
+}
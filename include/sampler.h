@@ -0,0 +1,175 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+// Random numbers for rendering.
+//
+// Integrators draw every random number through two calls,
+//   double  next_1d(Rng&);      // one dimension   (Russian roulette, light pick, ...)
+//   Sample2 next_2d(Rng&);      // two dimensions  (pixel jitter, light point, BSDF direction)
+// which each sampler overloads, so the integrators are templates over the sampler
+// type. std::mt19937_64 is the plain pseudo-random sampler. The QMC samplers below
+// describe one camera sample (pixel, sample number) and hand out successive
+// dimensions of a well-distributed point set, in the order the path asks for them:
+//   SobolSampler  - Owen-scrambled Sobol, shuffled per pixel (Burley 2020)
+//   ZSobolSampler - the same sequence indexed along a randomised Morton curve over
+//                   the image, which spreads the error as blue noise in screen space
+//                   (Ahmed & Wonka 2020, as in pbrt-v4's ZSobolSampler)
+// Both use the first two Sobol dimensions for every request, each request with its
+// own index shuffle and scramble, so 2D requests stay jointly stratified however
+// long the path is. Sample numbers within a pixel are best used in powers of two.
+
+// splitmix64 finaliser: decorrelates seeds
+inline uint64_t mix_seed(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+enum class SamplerType { RANDOM, SOBOL, ZSOBOL };
+
+inline bool parse_sampler(const char* s, SamplerType& out) {
+    if (!std::strcmp(s, "random")) { out = SamplerType::RANDOM; return true; }
+    if (!std::strcmp(s, "sobol"))  { out = SamplerType::SOBOL;  return true; }
+    if (!std::strcmp(s, "zsobol")) { out = SamplerType::ZSOBOL; return true; }
+    return false;
+}
+
+struct Sample2 { double u, v; };
+
+inline double next_1d(std::mt19937_64& g) { return std::uniform_real_distribution<double>(0.0,1.0)(g); }
+inline Sample2 next_2d(std::mt19937_64& g) { double u = next_1d(g); return { u, next_1d(g) }; }
+
+namespace sobol_detail {
+
+inline uint32_t reverse_bits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+// hash-based nested uniform (Owen) scramble in base 2 (Laine-Karras permutation)
+inline uint32_t owen(uint32_t x, uint32_t seed) {
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverse_bits(x);
+}
+
+// first two Sobol dimensions, 32-bit
+inline uint32_t sobol0(uint32_t i) { return reverse_bits(i); }
+inline uint32_t sobol1(uint32_t i) {
+    uint32_t r = 0;
+    for (uint32_t v = 1u << 31; i; i >>= 1, v ^= v >> 1) if (i & 1) r ^= v;
+    return r;
+}
+
+inline double to_unit(uint32_t x) { return (x + 0.5) * (1.0 / 4294967296.0); }
+
+inline uint32_t hash(uint64_t seed, uint64_t a) { return uint32_t(mix_seed(seed ^ mix_seed(a)) >> 32); }
+
+// scrambled point of the (shuffled) sequence at index i, for request 'dim'
+inline double point_1d(uint32_t i, uint64_t seed, uint32_t dim) {
+    return to_unit(owen(sobol0(i), hash(seed, 2ull*dim)));
+}
+inline Sample2 point_2d(uint32_t i, uint64_t seed, uint32_t dim) {
+    return { to_unit(owen(sobol0(i), hash(seed, 2ull*dim))), to_unit(owen(sobol1(i), hash(seed, 2ull*dim + 1))) };
+}
+
+inline uint64_t morton2(uint32_t x, uint32_t y) {
+    auto spread = [](uint64_t v){
+        v &= 0xffffffffull;
+        v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+        v = (v | (v << 8))  & 0x00ff00ff00ff00ffull;
+        v = (v | (v << 4))  & 0x0f0f0f0f0f0f0f0full;
+        v = (v | (v << 2))  & 0x3333333333333333ull;
+        v = (v | (v << 1))  & 0x5555555555555555ull;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+inline int log2_ceil(uint32_t n) { int k = 0; while ((1ull << k) < n) ++k; return k; }
+
+} // namespace sobol_detail
+
+// sample s of pixel (px, py); every pixel and every request gets its own shuffle
+struct SobolSampler {
+    SobolSampler(int px, int py, uint32_t s, uint64_t seed)
+        : index(s), pixelSeed(mix_seed(seed ^ mix_seed((uint64_t(uint32_t(py)) << 32) | uint32_t(px)))) {}
+
+    double get1d() {
+        uint32_t d = dim++;
+        return sobol_detail::point_1d(sobol_detail::owen(index, sobol_detail::hash(pixelSeed, ~uint64_t(d))), pixelSeed, d);
+    }
+    Sample2 get2d() {
+        uint32_t d = dim++;
+        return sobol_detail::point_2d(sobol_detail::owen(index, sobol_detail::hash(pixelSeed, ~uint64_t(d))), pixelSeed, d);
+    }
+
+private:
+    uint32_t index;
+    uint64_t pixelSeed;
+    uint32_t dim = 0;
+};
+
+// sample s of pixel (px, py) on a W x H image with spp samples per pixel; one
+// scramble for the whole image, sequence index from a permuted Morton order.
+// The index has to fit the 32-bit Sobol points: an image too large for spp is laid
+// out in square tiles that do fit, and samples past spp start a new round; each
+// tile and each round gets its own scramble instead of overflowing the index.
+struct ZSobolSampler {
+    ZSobolSampler(int px, int py, uint32_t s, uint64_t seed, int W, int H, int spp)
+        : log2Spp(sobol_detail::log2_ceil(uint32_t(spp))) {
+        const int sppDigits = (log2Spp + 1) / 2;
+        int log2Res = sobol_detail::log2_ceil(uint32_t(W > H ? W : H));
+        if (log2Res + sppDigits > 16) log2Res = 16 - sppDigits;
+        base4Digits = log2Res + sppDigits;
+        const uint32_t tile = (1u << log2Res) - 1;
+        const uint64_t tx = uint32_t(px) >> log2Res, ty = uint32_t(py) >> log2Res, round = uint64_t(s) >> log2Spp;
+        this->seed = mix_seed(seed ^ ((tx | ty | round) ? mix_seed(mix_seed((ty << 32) | tx) ^ round) : 0));
+        morton = (sobol_detail::morton2(uint32_t(px) & tile, uint32_t(py) & tile) << log2Spp)
+               | (s & ((1ull << log2Spp) - 1));
+    }
+
+    double get1d() { uint32_t d = dim++; return sobol_detail::point_1d(sample_index(d), seed, d); }
+    Sample2 get2d() { uint32_t d = dim++; return sobol_detail::point_2d(sample_index(d), seed, d); }
+
+private:
+    uint64_t seed, morton = 0;
+    int log2Spp, base4Digits = 0;
+    uint32_t dim = 0;
+
+    // Morton index with each base-4 digit permuted by a hash of the digits above it
+    uint32_t sample_index(uint32_t d) const {
+        static const uint8_t perms[24][4] = {
+            {0,1,2,3},{0,1,3,2},{0,2,1,3},{0,2,3,1},{0,3,2,1},{0,3,1,2},
+            {1,0,2,3},{1,0,3,2},{1,2,0,3},{1,2,3,0},{1,3,2,0},{1,3,0,2},
+            {2,1,0,3},{2,1,3,0},{2,0,1,3},{2,0,3,1},{2,3,0,1},{2,3,1,0},
+            {3,1,2,0},{3,1,0,2},{3,2,1,0},{3,2,0,1},{3,0,2,1},{3,0,1,2} };
+        const bool odd = log2Spp & 1;
+        uint64_t idx = 0;
+        for (int i = base4Digits - 1; i >= (odd ? 1 : 0); --i) {
+            int shift = 2*i - (odd ? 1 : 0);
+            int digit = int((morton >> shift) & 3);
+            uint64_t higher = morton >> (shift + 2);
+            int p = int((mix_seed(higher ^ (0x55555555ull * d) ^ seed) >> 24) % 24);
+            idx |= uint64_t(perms[p][digit]) << shift;
+        }
+        if (odd) idx |= (morton & 1) ^ (mix_seed((morton >> 1) ^ (0x55555555ull * d) ^ seed) & 1);
+        return uint32_t(idx);
+    }
+};
+
+inline double next_1d(SobolSampler& s)  { return s.get1d(); }
+inline Sample2 next_2d(SobolSampler& s) { return s.get2d(); }
+inline double next_1d(ZSobolSampler& s)  { return s.get1d(); }
+inline Sample2 next_2d(ZSobolSampler& s) { return s.get2d(); }
@@ -1,64 +1,162 @@
 #pragma once
 #include <vector>
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include "color.h"
 #include "ray.h"
 #include "hit.h"
 #include "material.h"
 #include "rectangle.h"
 #include "triangle.h"
+#include "plane.h"
 #include "sphere.h"
 #include "light.h"
+#include "path_guide.h"
+#include "sampler.h"
 
-struct Scene {
-    struct RectGeom { Rectangle R; Material mat; };
-    struct TriGeom  { Triangle  T; Material mat; };
+// --- primitives ---
+// A primitive type is anything with a Material 'mat' and
+//   bool intersect(const Ray&, double tmin, double tmax, Hit&) const;
+//   void grow_bounds(Vec3& lo, Vec3& hi) const;             // extend lo/hi by the primitive
+// Types that can also act as area lights (when their material is EMISSIVE) add
+//   EmitterSampler emitter_sampler(const Vec3& p) const;   // valid(), sample(u,v,wi,dist,pdf)
+//   double emitter_pdf(const Vec3& from) const;            // solid-angle pdf of sample()
+//   double area() const; Vec3 sample_point(u, v, Vec3& n) const;  // uniform by area
+// New primitives plug into SceneT<..., NewPrim> without changes to the scene.
 
-    std::vector<RectGeom> rects;   // walls + central floor/roof rects
-    std::vector<TriGeom>  tris;    // corner floor/roof triangles
-    std::vector<Sphere>   spheres; // optional objects
+struct RectGeom {
+    Rectangle R; Material mat;
+
+    bool intersect(const Ray& r, double tmin, double tmax, Hit& rec) const { return R.intersect(r, tmin, tmax, rec); }
+    void grow_bounds(Vec3& lo, Vec3& hi) const {
+        for (const Vec3& p : { R.v0, R.v0 + R.e1, R.v0 + R.e2, R.v0 + R.e1 + R.e2 }) { lo = vmin(lo, p); hi = vmax(hi, p); }
+    }
+
+    // spherical-rectangle sampling; the back face emits nothing
+    struct EmitterSampler {
+        SphQuad q; const Rectangle* R;
+        bool valid() const { return q.S > 1e-12; }
+        bool sample(double u, double v, Vec3& wi, double& dist, double& pdf) const {
+            Vec3 d = q.sample(u, v) - q.o;
+            dist = length(d); wi = d / dist; pdf = 1.0 / q.S;
+            return dot(R->normal, wi) < 0;
+        }
+    };
+    EmitterSampler emitter_sampler(const Vec3& p) const { return { SphQuad(R.v0, R.e1, R.e2, p), &R }; }
+    double emitter_pdf(const Vec3& from) const {
+        SphQuad q(R.v0, R.e1, R.e2, from);
+        return q.S > 1e-12 ? 1.0/q.S : 0.0;
+    }
+
+    // uniform point by area, for light subpaths (bdpt.h); n = emitting normal
+    double area() const { return length(cross(R.e1, R.e2)); }
+    Vec3 sample_point(double u, double v, Vec3& n) const { n = R.normal; return R.v0 + R.e1*u + R.e2*v; }
+};
+
+struct TriGeom {
+    Triangle T; Material mat;
+    bool intersect(const Ray& r, double tmin, double tmax, Hit& rec) const { return T.intersect(r, tmin, tmax, rec); }
+    void grow_bounds(Vec3& lo, Vec3& hi) const {
+        for (const Vec3& p : { T.v0, T.v1, T.v2 }) { lo = vmin(lo, p); hi = vmax(hi, p); }
+    }
+};
+
+// infinite plane; it has no extent, so it leaves the bounds alone
+struct PlaneGeom {
+    Plane P; Material mat;
+    bool intersect(const Ray& r, double tmin, double tmax, Hit& rec) const { return P.intersect(r, tmin, tmax, rec); }
+    void grow_bounds(Vec3&, Vec3&) const {}
+};
+
+// Primitives a path touched, as a 64-bit Bloom mask over (kind, index). Used by the
+// G-buffer cache (gbuffer.h) to tell which cached samples a material edit affects.
+struct PathRecord {
+    uint64_t mask = 0;
+    static uint64_t bit(int kind, int index) {
+        return 1ull << (((uint64_t(index) * 4 + kind) * 0x9e3779b97f4a7c15ull) >> 58);
+    }
+    void touch(int kind, int index) { mask |= bit(kind, index); }
+};
+
+template <class P, class = void> struct is_emitter_prim : std::false_type {};
+template <class P>
+struct is_emitter_prim<P, std::void_t<decltype(std::declval<const P&>().emitter_pdf(Vec3()))>> : std::true_type {};
+
+// compile-time set of material types a scene may contain
+template <MatType... Ms> struct MatList {
+    static constexpr bool has(MatType m) { return ((m == Ms) || ...); }
+};
+using AllMaterials = MatList<MatType::LAMBERT, MatType::MIRROR, MatType::EMISSIVE>;
+
+// Scene over a compile-time list of primitive types, one vector per type.
+// Traversal is a fold over the list and shading only instantiates the branches
+// for materials in Mats, so e.g. a scene without spheres or mirrors carries no
+// sphere tests and no mirror branch at all.
+template <class Mats, class... Prims>
+struct SceneT {
+    using Materials = Mats;
+
+    std::tuple<std::vector<Prims>...> geom;
     std::vector<RectLight> lights; // roof area light
 
+    template <class P> std::vector<P>& prims() { return std::get<std::vector<P>>(geom); }
+    template <class P> const std::vector<P>& prims() const { return std::get<std::vector<P>>(geom); }
+    // p's material must be one this scene type was compiled for (the shaders have no
+    // branch for the others); the same holds for edits through prims<P>()
+    template <class P> void add(const P& p) {
+        assert(Mats::has(p.mat.type) && "material type not in this scene's MatList");
+        prims<P>().push_back(p);
+    }
+
     // camera background (not really visible once room is closed)
     Color background(const Ray& r) const {
         double t = 0.5 * (r.dir.y + 1.0);
         return Color((1.0 - t) + t * 0.5, (1.0 - t) + t * 0.7, 1.0);
     }
 
-    enum ObjType { NONE, RECT, TRI, SPHERE };
-    struct HitAny { bool hit=false; Hit rec; ObjType type=NONE; int index=-1; };
+    // axis-aligned bounds of all primitives
+    void bounds(Vec3& lo, Vec3& hi) const {
+        lo = Vec3(1e30, 1e30, 1e30); hi = Vec3(-1e30, -1e30, -1e30);
+        std::apply([&](const auto&... v){ (std::for_each(v.begin(), v.end(), [&](const auto& g){ g.grow_bounds(lo, hi); }), ...); }, geom);
+    }
+
+    // kind = position of the primitive's type in Prims...
+    struct HitAny { bool hit=false; Hit rec; int kind=-1; int index=-1; };
 
     HitAny trace_first(const Ray& r, double tmin, double tmax) const {
         Hit temp; HitAny out; double closest = tmax;
-
-        for (int i=0;i<(int)rects.size();++i){
-            if (rects[i].R.intersect(r, tmin, closest, temp)) { out={true,temp,RECT,i}; closest=temp.t; }
-        }
-        for (int i=0;i<(int)tris.size();++i){
-            if (tris[i].T.intersect(r, tmin, closest, temp))   { out={true,temp,TRI ,i}; closest=temp.t; }
-        }
-        for (int i=0;i<(int)spheres.size();++i){
-            if (spheres[i].intersect(r, tmin, closest, temp))  { out={true,temp,SPHERE,i}; closest=temp.t; }
-        }
+        trace_all(r, tmin, closest, temp, out, std::index_sequence_for<Prims...>{});
         return out;
     }
 
     bool occluded(const Vec3& p, const Vec3& dir, double maxDist) const {
-        Hit h;
-        // rects
-        for (const auto& g : rects) if (g.R.intersect(Ray(p,dir), 1e-4, maxDist-1e-4, h)) return true;
-        // tris
-        for (const auto& g : tris)  if (g.T.intersect(Ray(p,dir), 1e-4, maxDist-1e-4, h)) return true;
-        // spheres
-        for (const auto& s : spheres) if (s.intersect(Ray(p,dir), 1e-4, maxDist-1e-4, h)) return true;
-        return false;
+        Ray ray(p, dir);
+        return std::apply([&](const auto&... v){ return (any_hit(v, ray, 1e-4, maxDist-1e-4) || ...); }, geom);
+    }
+    // any hit on r within [tmin, tmax]
+    bool occluded(const Ray& r, double tmin, double tmax) const {
+        return std::apply([&](const auto&... v){ return (any_hit(v, r, tmin, tmax) || ...); }, geom);
+    }
+
+    const Material* material_of(const HitAny& h) const {
+        return material_at(h, std::index_sequence_for<Prims...>{});
+    }
+
+    // solid-angle pdf with which direct_light_mis would have sampled the emitter
+    // in h from point 'from' (one sample); 0 for primitives that are not emitters
+    double emitter_pdf(const HitAny& h, const Vec3& from) const {
+        return emitter_pdf_at(h, from, std::index_sequence_for<Prims...>{});
     }
 
     // --- direct MC (same as before) ---
-    Color direct_light_mc(const HitAny& h, const Color& albedo, int nSamples, std::mt19937_64& rng) const {
+    template <class Rng>
+    Color direct_light_mc(const HitAny& h, const Color& albedo, int nSamples, Rng& rng) const {
         if (lights.empty() || nSamples<=0) return Color(0,0,0);
-        std::uniform_real_distribution<double> U(0.0,1.0);
         const double invPi = 1.0/3.14159265358979323846;
         Color L(0,0,0);
         for (const auto& Lrect : lights){
@@ -67,7 +165,8 @@ struct Scene {
             int used = 0;
             for (int py=0; py<n && used<nSamples; ++py){
                 for (int px=0; px<n && used<nSamples; ++px, ++used){
-                    double u = (px + U(rng))/n, v = (py + U(rng))/n;
+                    Sample2 j = next_2d(rng);
+                    double u = (px + j.u)/n, v = (py + j.v)/n;
                     Vec3 y = Lrect.sample(u,v);
                     Vec3 d = y - h.rec.p;
                     double d2 = dot(d,d), d1 = std::sqrt(d2);
@@ -87,50 +186,259 @@ struct Scene {
     }
 
     // cosine hemisphere sampling (as before)
-    Vec3 sample_cosine_hemisphere(const Vec3& n, std::mt19937_64& rng) const {
-        std::uniform_real_distribution<double> U(0.0, 1.0);
-        double r1 = 2.0*3.14159265358979323846*U(rng), r2 = U(rng), r2s = std::sqrt(r2);
+    template <class Rng>
+    Vec3 sample_cosine_hemisphere(const Vec3& n, Rng& rng) const {
+        Sample2 r = next_2d(rng);
+        double r1 = 2.0*3.14159265358979323846*r.u, r2 = r.v, r2s = std::sqrt(r2);
         Vec3 local(std::cos(r1)*r2s, std::sin(r1)*r2s, std::sqrt(1.0-r2));
         Vec3 a = (std::fabs(n.x) > 0.1) ? Vec3(0,1,0) : Vec3(1,0,0);
         Vec3 t = normalize(cross(a,n)), b = cross(n,t);
         return normalize(t*local.x + b*local.y + n*local.z);
     }
 
-    // recursive shader (mirror + diffuse GI)
-    Color shade_path(const Ray& r, int depth, int directSamples, std::mt19937_64& rng) const {
+    // --- direct lighting, solid-angle sampling of the RectLights ---
+    // Same estimator as direct_light_mc, but points are drawn uniformly in the solid
+    // angle each light subtends (spherical rectangle), so the A*G term collapses to a
+    // constant 1/pdf and close or grazing lights no longer produce huge weights.
+    template <class Rng>
+    Color direct_light_sa(const HitAny& h, const Color& albedo, int nSamples, Rng& rng) const {
+        if (lights.empty() || nSamples<=0) return Color(0,0,0);
+        const double invPi = 1.0/3.14159265358979323846;
+        Color L(0,0,0);
+        for (const auto& Lrect : lights){
+            SphQuad q(Lrect.v0, Lrect.e1, Lrect.e2, h.rec.p);
+            if (q.S <= 1e-12) continue;
+            int n = std::ceil(std::sqrt((double)nSamples)); // stratify a bit
+            int used = 0;
+            for (int py=0; py<n && used<nSamples; ++py){
+                for (int px=0; px<n && used<nSamples; ++px, ++used){
+                    Sample2 j = next_2d(rng);
+                    Vec3 y = q.sample((px + j.u)/n, (py + j.v)/n);
+                    Vec3 d = y - h.rec.p;
+                    double d1 = length(d);
+                    Vec3 wi = d / d1;
+                    double cosx = dot(h.rec.n, wi);
+                    if (cosx<=0 || dot(Lrect.normal, -wi)<=0) continue;
+                    if (occluded(h.rec.p, wi, d1)) continue;
+                    Color c = Lrect.Le * (invPi*cosx*q.S / nSamples);
+                    c.r *= albedo.r; c.g *= albedo.g; c.b *= albedo.b;
+                    L = L + c;
+                }
+            }
+        }
+        return L;
+    }
+
+    // --- direct lighting with MIS ---
+    // RectLights (not hittable by BSDF rays) get weight 1. Emissive primitives are
+    // sampled through their EmitterSampler (spherical rectangle for rects, cone for
+    // spheres); those samples are weighted
+    // against cosine BSDF sampling with the power heuristic. shade_path_mis adds the
+    // complementary weight when its BSDF ray lands on the emitter.
+    template <class Rng>
+    Color direct_light_mis(const HitAny& h, const Color& albedo, int nSamples, Rng& rng) const {
+        if (nSamples<=0) return Color(0,0,0);
+        Color L = direct_light_sa(h, albedo, nSamples, rng);
+        const double invPi = 1.0/3.14159265358979323846;
+        int n = std::ceil(std::sqrt((double)nSamples));
+
+        auto add = [&](const Color& Le, double cosx, double pl){
+            double nl = nSamples*pl, pb = cosx*invPi;
+            double w = nl*nl / (nl*nl + pb*pb);
+            Color c = Le * (invPi*cosx*w / (pl*nSamples));
+            c.r *= albedo.r; c.g *= albedo.g; c.b *= albedo.b;
+            L = L + c;
+        };
+
+        if constexpr (Mats::has(MatType::EMISSIVE)) {
+            std::apply([&](const auto&... v){ (sample_emitters(v, h, n, nSamples, rng, add), ...); }, geom);
+        }
+        return L;
+    }
+
+    // recursive shader (mirror + diffuse GI); rec, if given, collects the primitives hit;
+    // guide, if given, learns incident light and steers the diffuse bounces
+    template <class Rng>
+    Color shade_path(const Ray& r, int depth, int directSamples, Rng& rng,
+                     PathRecord* rec = nullptr, PathGuide* guide = nullptr) const {
         if (depth<=0) return Color(0,0,0);
         auto h = trace_first(r, 1e-4, 1e9);
         if (!h.hit) return background(r);
+        return shade_path_hit(r, h, depth, directSamples, rng, rec, guide);
+    }
 
-        const Material* m = nullptr;
-        if      (h.type==RECT)   m = &rects[h.index].mat;
-        else if (h.type==TRI)    m = &tris[h.index].mat;
-        else if (h.type==SPHERE) m = &spheres[h.index].mat;
+    // shade_path from the already traced hit h of r (G-buffer re-renders start here)
+    template <class Rng>
+    Color shade_path_hit(const Ray& r, const HitAny& h, int depth, int directSamples, Rng& rng,
+                         PathRecord* rec = nullptr, PathGuide* guide = nullptr) const {
+        if (rec) rec->touch(h.kind, h.index);
+        const Material* m = material_of(h);
         if (!m) return Color(0,0,0);
 
-        if (m->type == MatType::EMISSIVE) {
-        // Only emit if we’re hitting the front face of the lamp
-        if (h.rec.front_face)
-            return m->emission;
-        else
-            return Color(0,0,0);
+        if constexpr (Mats::has(MatType::EMISSIVE)) {
+            if (m->type == MatType::EMISSIVE) {
+                // Only emit if we’re hitting the front face of the lamp
+                return h.rec.front_face ? m->emission : Color(0,0,0);
+            }
+        }
+
+        if constexpr (Mats::has(MatType::MIRROR)) {
+            if (m->type == MatType::MIRROR) {
+                Vec3 refl = reflect(r.dir, h.rec.n);
+                return shade_path(Ray(h.rec.p, refl), depth-1, directSamples, rng, rec, guide);
+            }
+        }
+        if constexpr (!Mats::has(MatType::LAMBERT)) return Color(0,0,0);
+
+        Color Ld = direct_light_sa(h, m->albedo, directSamples, rng);
+
+        double ps = std::min(0.95, std::max({m->albedo.r, m->albedo.g, m->albedo.b}));
+        if (depth<=2) ps = 1.0;
+        if (next_1d(rng) > ps) return Ld;
+        if (guide) return Ld + guided_bounce(h, *m, depth, directSamples, rng, ps, rec, *guide);
+
+        Vec3 wi = sample_cosine_hemisphere(h.rec.n, rng);
+        Color Li = shade_path(Ray(h.rec.p, wi), depth-1, directSamples, rng, rec);
+        Color Lind(m->albedo.r*Li.r/ps, m->albedo.g*Li.g/ps, m->albedo.b*Li.b/ps);
+        return Ld + Lind;
+    }
+
+    // Path tracer with MIS between light sampling (direct_light_mis) and cosine BSDF
+    // sampling. bsdfPdf is the solid-angle pdf of the direction that produced r, or 0
+    // for camera/mirror rays, which always see emitters at full weight.
+    template <class Rng>
+    Color shade_path_mis(const Ray& r, int depth, int directSamples, Rng& rng,
+                         double bsdfPdf = 0.0, PathRecord* rec = nullptr) const {
+        if (depth<=0) return Color(0,0,0);
+        auto h = trace_first(r, 1e-4, 1e9);
+        if (!h.hit) return background(r);
+        return shade_path_mis_hit(r, h, depth, directSamples, rng, bsdfPdf, rec);
     }
 
-        if (m->type == MatType::MIRROR) {
-            Vec3 refl = reflect(r.dir, h.rec.n);
-            return shade_path(Ray(h.rec.p, refl), depth-1, directSamples, rng);
+    template <class Rng>
+    Color shade_path_mis_hit(const Ray& r, const HitAny& h, int depth, int directSamples, Rng& rng,
+                             double bsdfPdf = 0.0, PathRecord* rec = nullptr) const {
+        if (rec) rec->touch(h.kind, h.index);
+        const Material* m = material_of(h);
+        if (!m) return Color(0,0,0);
+
+        if constexpr (Mats::has(MatType::EMISSIVE)) {
+            if (m->type == MatType::EMISSIVE) {
+                if (!h.rec.front_face) return Color(0,0,0);
+                if (bsdfPdf <= 0 || directSamples <= 0) return m->emission;
+                double nl = directSamples * emitter_pdf(h, r.origin);
+                return m->emission * (bsdfPdf*bsdfPdf / (bsdfPdf*bsdfPdf + nl*nl));
+            }
         }
 
-        Color Ld = direct_light_mc(h, m->albedo, directSamples, rng);
+        if constexpr (Mats::has(MatType::MIRROR)) {
+            if (m->type == MatType::MIRROR) {
+                Vec3 refl = reflect(r.dir, h.rec.n);
+                return shade_path_mis(Ray(h.rec.p, refl), depth-1, directSamples, rng, 0.0, rec);
+            }
+        }
+        if constexpr (!Mats::has(MatType::LAMBERT)) return Color(0,0,0);
+
+        // at the last vertex no BSDF ray follows to add the complementary weight, so
+        // emitters are left to the next depth exactly as in shade_path
+        Color Ld = depth > 1 ? direct_light_mis(h, m->albedo, directSamples, rng)
+                             : direct_light_sa(h, m->albedo, directSamples, rng);
 
         double ps = std::min(0.95, std::max({m->albedo.r, m->albedo.g, m->albedo.b}));
         if (depth<=2) ps = 1.0;
-        std::uniform_real_distribution<double> U(0.0,1.0);
-        if (U(rng) > ps) return Ld;
+        if (next_1d(rng) > ps) return Ld;
 
         Vec3 wi = sample_cosine_hemisphere(h.rec.n, rng);
-        Color Li = shade_path(Ray(h.rec.p, wi), depth-1, directSamples, rng);
+        double pdf = std::max(1e-12, dot(h.rec.n, wi)) / 3.14159265358979323846;
+        Color Li = shade_path_mis(Ray(h.rec.p, wi), depth-1, directSamples, rng, pdf, rec);
         Color Lind(m->albedo.r*Li.r/ps, m->albedo.g*Li.g/ps, m->albedo.b*Li.b/ps);
         return Ld + Lind;
     }
+
+private:
+    // diffuse bounce of shade_path drawn from the one-sample mixture
+    // alpha * guide + (1 - alpha) * cosine, recording Li/pdf for the next pass
+    template <class Rng>
+    Color guided_bounce(const HitAny& h, const Material& m, int depth, int directSamples, Rng& rng,
+                        double ps, PathRecord* rec, PathGuide& guide) const {
+        const double invPi = 1.0/3.14159265358979323846;
+        auto& leaf = guide.leaf(h.rec.p);
+        double a = leaf.sampling.valid() ? guide.alpha : 0.0;
+        Vec3 wi = (a > 0 && next_1d(rng) < a) ? leaf.sampling.sample(rng) : sample_cosine_hemisphere(h.rec.n, rng);
+        double cosx = dot(h.rec.n, wi);
+        if (cosx <= 0) return Color(0,0,0);
+        double pdf = (1.0 - a)*cosx*invPi + (a > 0 ? a*leaf.sampling.pdf(wi) : 0.0);
+        Color Li = shade_path(Ray(h.rec.p, wi), depth-1, directSamples, rng, rec, &guide);
+        if (guide.training) guide.record(leaf, wi, (0.2126*Li.r + 0.7152*Li.g + 0.0722*Li.b) / pdf);
+        double f = cosx*invPi / (pdf*ps);
+        return Color(m.albedo.r*Li.r*f, m.albedo.g*Li.g*f, m.albedo.b*Li.b*f);
+    }
+
+    template <size_t... I>
+    void trace_all(const Ray& r, double tmin, double& closest, Hit& temp, HitAny& out, std::index_sequence<I...>) const {
+        (trace_list<I>(r, tmin, closest, temp, out), ...);
+    }
+    template <size_t I>
+    void trace_list(const Ray& r, double tmin, double& closest, Hit& temp, HitAny& out) const {
+        const auto& v = std::get<I>(geom);
+        for (int i=0;i<(int)v.size();++i){
+            if (v[i].intersect(r, tmin, closest, temp)) { out={true,temp,int(I),i}; closest=temp.t; }
+        }
+    }
+
+    template <class P>
+    static bool any_hit(const std::vector<P>& v, const Ray& r, double tmin, double tmax) {
+        Hit h;
+        for (const auto& g : v) if (g.intersect(r, tmin, tmax, h)) return true;
+        return false;
+    }
+
+    template <size_t... I>
+    const Material* material_at(const HitAny& h, std::index_sequence<I...>) const {
+        const Material* m = nullptr;
+        ((h.kind == int(I) ? (m = &std::get<I>(geom)[h.index].mat, true) : false) || ...);
+        return m;
+    }
+
+    template <size_t... I>
+    double emitter_pdf_at(const HitAny& h, const Vec3& from, std::index_sequence<I...>) const {
+        double pdf = 0.0;
+        ((h.kind == int(I) ? (pdf = emitter_pdf_of(std::get<I>(geom)[h.index], from), true) : false) || ...);
+        return pdf;
+    }
+    template <class P>
+    static double emitter_pdf_of(const P& g, const Vec3& from) {
+        if constexpr (is_emitter_prim<P>::value) return g.emitter_pdf(from);
+        else return 0.0;
+    }
+
+    // nSamples stratified light samples on every emissive primitive in v
+    template <class P, class Add, class Rng>
+    void sample_emitters(const std::vector<P>& v, const HitAny& h, int n, int nSamples, Rng& rng, Add& add) const {
+        if constexpr (is_emitter_prim<P>::value) {
+            for (const auto& g : v){
+                if (g.mat.type != MatType::EMISSIVE) continue;
+                auto es = g.emitter_sampler(h.rec.p);
+                if (!es.valid()) continue;
+                int used = 0;
+                for (int py=0; py<n && used<nSamples; ++py){
+                    for (int px=0; px<n && used<nSamples; ++px, ++used){
+                        Vec3 wi; double dist, pl;
+                        Sample2 j = next_2d(rng);
+                        if (!es.sample((px + j.u)/n, (py + j.v)/n, wi, dist, pl)) continue;
+                        double cosx = dot(h.rec.n, wi);
+                        if (cosx<=0) continue;
+                        if (occluded(h.rec.p, wi, dist)) continue;
+                        add(g.mat.emission, cosx, pl);
+                    }
+                }
+            }
+        }
+    }
 };
+
+// the general scene used by the room tools: rects, triangles and spheres, all materials
+using Scene = SceneT<AllMaterials, RectGeom, TriGeom, Sphere>;
+
+// the open scenes of the rt3..rt7 tools: spheres over infinite planes, lit by the sky
+using PlaneScene = SceneT<AllMaterials, Sphere, PlaneGeom>;
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "scene.h"
+#include "hex_room.h"
+
+// Named scenes that tools can build on request (render daemon, batch tools).
+//   room        - furnished hex room as in rt_room.cpp
+//   room_empty  - bare grey hex room lit only by the roof lamp
+inline bool build_named_scene(const std::string& id, Scene& S){
+    if (id == "room") { build_hex_room_scene(S); return true; }
+    if (id == "room_empty") { build_bare_room(S); return true; }
+    return false;
+}
+
+inline std::vector<std::string> named_scenes(){ return { "room", "room_empty" }; }
@@ -0,0 +1,122 @@
+#pragma once
+// Line protocol between rt_daemon and rt_client over a Unix domain socket (POSIX).
+//
+// client -> daemon, one command per line:
+//   RENDER id=7 scene=room w=64 h=64 spp=8 ls=4 d=8 seed=1 prio=0 eye=-1,0,0 integrator=path
+//          sampler=random [group=viewport]
+//   CANCEL id=7
+//   QUIT
+// Numbers are plain decimal integers (seed: 0 .. 2^64-1); a RENDER with a malformed
+// or out-of-range value (w and h: 2 .. 16384) is answered with ERROR and not queued.
+// Jobs run one at a time. A RENDER with group=g supersedes the same connection's
+// earlier jobs in group g: queued ones are dropped and a running one stops at its
+// next row band, each answered with CANCELLED. Jobs without a group are never
+// superseded.
+// daemon -> client:
+//   QUEUED <id>
+//   ROWS <id> <y0> <y1> <nbytes>\n<nbytes of RGB8, image rows y0..y1-1, top row first>
+//   DONE <id> <seconds>
+//   CANCELLED <id>
+//   ERROR <id> <message>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+inline const char* default_socket_path() { return "/tmp/raytracer.sock"; }
+
+inline bool write_all(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t k = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k; n -= size_t(k);
+    }
+    return true;
+}
+
+inline bool write_line(int fd, const std::string& s) {
+    std::string l = s + "\n";
+    return write_all(fd, l.data(), l.size());
+}
+
+// Buffered reader for a socket: whole lines or exact byte counts.
+struct SocketReader {
+    int fd;
+    std::string buf;
+    explicit SocketReader(int f) : fd(f) {}
+
+    bool fill() {
+        char tmp[4096];
+        ssize_t k;
+        do { k = ::recv(fd, tmp, sizeof(tmp), 0); } while (k < 0 && errno == EINTR);
+        if (k <= 0) return false;
+        buf.append(tmp, size_t(k));
+        return true;
+    }
+    bool read_line(std::string& line) {
+        size_t pos;
+        while ((pos = buf.find('\n')) == std::string::npos) if (!fill()) return false;
+        line = buf.substr(0, pos);
+        buf.erase(0, pos + 1);
+        return true;
+    }
+    bool read_bytes(char* out, size_t n) {
+        while (buf.size() < n) if (!fill()) return false;
+        buf.copy(out, n);
+        buf.erase(0, n);
+        return true;
+    }
+};
+
+// "CMD k=v k=v" -> cmd, {k: v}
+inline std::string parse_command(const std::string& line, std::map<std::string, std::string>& kv) {
+    std::istringstream in(line);
+    std::string cmd, tok;
+    in >> cmd;
+    while (in >> tok) {
+        size_t eq = tok.find('=');
+        if (eq != std::string::npos) kv[tok.substr(0, eq)] = tok.substr(eq + 1);
+    }
+    return cmd;
+}
+
+// Integer value of k into out, which keeps its value when k is absent. False when the
+// value is not a whole decimal number that fits T.
+template <class T>
+inline bool kv_int(const std::map<std::string, std::string>& kv, const char* k, T& out) {
+    auto it = kv.find(k);
+    if (it == kv.end()) return true;
+    const char* s = it->second.c_str();
+    char* end = nullptr;
+    errno = 0;
+    if constexpr (std::is_signed<T>::value) {
+        long long v = std::strtoll(s, &end, 10);
+        if (errno || end == s || *end || v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max()) return false;
+        out = T(v);
+    } else {
+        unsigned long long v = std::strtoull(s, &end, 10);
+        if (errno || end == s || *end || *s == '-' || v > std::numeric_limits<T>::max()) return false;
+        out = T(v);
+    }
+    return true;
+}
+
+inline std::string kv_str(const std::map<std::string, std::string>& kv, const char* k, const std::string& def) {
+    auto it = kv.find(k);
+    return it == kv.end() ? def : it->second;
+}
+
+inline sockaddr_un unix_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    return addr;
+}
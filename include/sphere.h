@@ -2,6 +2,7 @@
 #include "ray.h"
 #include "hit.h"
 #include "material.h"
+#include <algorithm>
 
 struct Sphere {
     Vec3 c; double r;
@@ -35,4 +36,50 @@ struct Sphere {
         rec.set_face_normal(ray.dir, outward);
         return true;
     }
+
+    // Area-light interface (see scene.h): uniform directions inside the cone the
+    // sphere subtends from p, pdf per steradian. Invalid when p is inside the sphere.
+    struct EmitterSampler {
+        const Sphere* s = nullptr; Vec3 p{}, t{}, b{}, w{}; double cosMax = 1, pdf = 0;
+        bool valid() const { return pdf > 0; }
+        bool sample(double u, double v, Vec3& wi, double& dist, double& pdfOut) const {
+            double cosT = 1.0 - u * (1.0 - cosMax), sinT = std::sqrt(std::max(0.0, 1.0 - cosT*cosT));
+            double phi = 2.0*3.14159265358979323846*v;
+            wi = normalize(t*(std::cos(phi)*sinT) + b*(std::sin(phi)*sinT) + w*cosT);
+            Hit hs;
+            if (!s->intersect(Ray(p, wi), 1e-4, 1e9, hs)) return false;
+            dist = hs.t; pdfOut = pdf;
+            return true;
+        }
+    };
+    EmitterSampler emitter_sampler(const Vec3& p) const {
+        EmitterSampler es{this, p};
+        Vec3 d = c - p;
+        double d2 = dot(d, d);
+        if (d2 <= r*r) return es;
+        es.cosMax = std::sqrt(std::max(0.0, 1.0 - r*r/d2));
+        es.pdf = cone_pdf(p);
+        es.w = d / std::sqrt(d2);
+        Vec3 a = (std::fabs(es.w.x) > 0.1) ? Vec3(0,1,0) : Vec3(1,0,0);
+        es.t = normalize(cross(a,es.w)); es.b = cross(es.w,es.t);
+        return es;
+    }
+    double emitter_pdf(const Vec3& from) const { return cone_pdf(from); }
+
+    void grow_bounds(Vec3& lo, Vec3& hi) const { lo = vmin(lo, c - Vec3(r,r,r)); hi = vmax(hi, c + Vec3(r,r,r)); }
+
+    double area() const { return 4.0*3.14159265358979323846*r*r; }
+    Vec3 sample_point(double u, double v, Vec3& n) const {
+        double z = 1.0 - 2.0*u, s = std::sqrt(std::max(0.0, 1.0 - z*z)), phi = 2.0*3.14159265358979323846*v;
+        n = Vec3(s*std::cos(phi), s*std::sin(phi), z);
+        return c + n*r;
+    }
+
+    double cone_pdf(const Vec3& p) const {
+        Vec3 d = c - p;
+        double d2 = dot(d, d);
+        if (d2 <= r*r) return 0.0;
+        double cosMax = std::sqrt(std::max(0.0, 1.0 - r*r/d2));
+        return 1.0 / (2.0*3.14159265358979323846*(1.0 - cosMax));
+    }
 };
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "color.h"
+#include "ray.h"
+#include "scene.h"
+#include "sampler.h"
+
+// Path splitting at the first diffuse vertex and throughput-based Russian roulette
+// for the path integrator, with both factors chosen per render for efficiency
+// (1 / (variance x time)), in the spirit of Rath et al. 2022 (EARS).
+//
+// shade_path spends the camera ray, the first hit and its ls shadow rays on a single
+// indirect estimate. Here the first diffuse vertex sends 'split' indirect rays, each
+// carrying 1/split of the throughput, with no roulette. Every other diffuse vertex
+// (including the first one when split is 1) continues with probability
+//   q = min(1, max channel of (throughput x albedo) / threshold)
+// so the split branches, which carry little weight, are cut back quickly while
+// bright paths keep going. threshold 0 keeps shade_path's rule (max albedo, capped
+// at 0.95, and no roulette in the last two bounces), so split 1 with threshold 0
+// is shade_path's estimator.
+//
+// tune() picks the pair with the lowest variance x time reported by a measurement
+// callback; tune_split_rr (render.h) measures with short pilot renders of the scene.
+struct SplitRR {
+    int split = 1;              // indirect rays at the first diffuse vertex
+    double threshold = 0;       // roulette beyond it; 0 = shade_path's rule
+    double qmin = 0.05;         // lowest survival probability
+
+    // Coordinate search: threshold at the current split, then split, then threshold
+    // again. cost(const SplitRR&) returns variance x time per sample (lower is better).
+    template <class Cost>
+    void tune(Cost cost) {
+        static const int splits[] = { 1, 2, 4, 8 };
+        static const double thresholds[] = { 0.0, 0.1, 0.3, 1.0 };
+        double best = cost(*this);
+        auto search = [&](auto& field, const auto& values){
+            auto keep = field;
+            for (auto v : values) {
+                if (v == keep) continue;
+                field = v;
+                double c = cost(*this);
+                if (c < best) { best = c; keep = v; }
+            }
+            field = keep;
+        };
+        search(threshold, thresholds);
+        search(split, splits);
+        search(threshold, thresholds);
+    }
+};
+
+// Radiance along r like SceneT::shade_path, with s's splitting and roulette. beta is
+// the throughput from the camera to r's origin; first: no diffuse vertex yet.
+template <class SceneType, class Rng>
+Color shade_path_split(const SceneType& S, const Ray& r, int depth, int directSamples, Rng& rng,
+                       const SplitRR& s, const Color& beta = Color(1,1,1), bool first = true) {
+    using Mats = typename SceneType::Materials;
+    if (depth<=0) return Color(0,0,0);
+    auto h = S.trace_first(r, 1e-4, 1e9);
+    if (!h.hit) return S.background(r);
+    const Material* m = S.material_of(h);
+    if (!m) return Color(0,0,0);
+
+    if constexpr (Mats::has(MatType::EMISSIVE)) {
+        if (m->type == MatType::EMISSIVE) return h.rec.front_face ? m->emission : Color(0,0,0);
+    }
+    if constexpr (Mats::has(MatType::MIRROR)) {
+        if (m->type == MatType::MIRROR) {
+            Vec3 refl = reflect(r.dir, h.rec.n);
+            return shade_path_split(S, Ray(h.rec.p, refl), depth-1, directSamples, rng, s, beta, first);
+        }
+    }
+    if constexpr (!Mats::has(MatType::LAMBERT)) return Color(0,0,0);
+
+    const Color& a = m->albedo;
+    Color L = S.direct_light_sa(h, a, directSamples, rng);
+    int n = first ? std::max(1, s.split) : 1;
+    double q = 1.0;     // splitting replaces roulette at the first vertex
+    if (n == 1) {
+        if (s.threshold > 0) q = std::clamp(std::max({beta.r*a.r, beta.g*a.g, beta.b*a.b}) / s.threshold, s.qmin, 1.0);
+        else if (depth > 2) q = std::min(0.95, std::max({a.r, a.g, a.b}));
+    }
+
+    for (int k = 0; k < n; ++k) {
+        if (q < 1.0 && next_1d(rng) > q) continue;
+        double w = 1.0 / (n * q);
+        Color b(beta.r*a.r*w, beta.g*a.g*w, beta.b*a.b*w);
+        Vec3 wi = S.sample_cosine_hemisphere(h.rec.n, rng);
+        Color Li = shade_path_split(S, Ray(h.rec.p, wi), depth-1, directSamples, rng, s, b, false);
+        L = L + Color(a.r*Li.r*w, a.g*Li.g*w, a.b*Li.b*w);
+    }
+    return L;
+}
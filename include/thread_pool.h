@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads shared across renders.
+// parallel_for(n, fn) hands out indices 0..n-1 one at a time (rows, tiles, ...)
+// and blocks until all of them are done. fn(index, threadId).
+struct ThreadPool {
+    explicit ThreadPool(int n = 0) {
+        if (n <= 0) n = std::max(1u, std::thread::hardware_concurrency());
+        for (int t = 0; t < n; ++t) threads.emplace_back([this, t]{ loop(t); });
+    }
+    ~ThreadPool() {
+        { std::lock_guard<std::mutex> lk(m); quit = true; }
+        cv.notify_all();
+        for (auto& th : threads) th.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)threads.size(); }
+
+    void parallel_for(int n, const std::function<void(int,int)>& fn) {
+        if (n <= 0) return;
+        std::unique_lock<std::mutex> lk(m);
+        job = &fn; count = n; next = 0; active = (int)threads.size(); ++generation;
+        cv.notify_all();
+        done_cv.wait(lk, [&]{ return active == 0; });
+        job = nullptr;
+    }
+
+private:
+    void loop(int tid) {
+        unsigned long seen = 0;
+        while (true) {
+            const std::function<void(int,int)>* fn; int n;
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv.wait(lk, [&]{ return quit || generation != seen; });
+                if (quit) return;
+                seen = generation; fn = job; n = count;
+            }
+            for (int i = next.fetch_add(1); i < n; i = next.fetch_add(1)) (*fn)(i, tid);
+            std::lock_guard<std::mutex> lk(m);
+            if (--active == 0) done_cv.notify_one();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex m;
+    std::condition_variable cv, done_cv;
+    const std::function<void(int,int)>* job = nullptr;
+    int count = 0, active = 0;
+    std::atomic<int> next{0};
+    unsigned long generation = 0;
+    bool quit = false;
+};
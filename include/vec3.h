@@ -17,4 +17,6 @@ inline Vec3 cross(const Vec3& a,const Vec3& b){
 }
 inline double length(const Vec3& v){ return std::sqrt(dot(v,v)); }
 inline Vec3 normalize(const Vec3& v){ double L=length(v); return L? v/L : v; }
+inline Vec3 vmin(const Vec3& a,const Vec3& b){ return { std::fmin(a.x,b.x), std::fmin(a.y,b.y), std::fmin(a.z,b.z) }; }
+inline Vec3 vmax(const Vec3& a,const Vec3& b){ return { std::fmax(a.x,b.x), std::fmax(a.y,b.y), std::fmax(a.z,b.z) }; }
 inline Vec3 reflect(const Vec3& v,const Vec3& n){ return v - n*(2.0*dot(v,n)); }
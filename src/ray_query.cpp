@@ -0,0 +1,116 @@
+// Implementation of the batched ray-query API in ray_query.h.
+#include "ray_query.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "scene.h"
+#include "scene_registry.h"
+#include "thread_pool.h"
+
+static Vec3 v3(const double a[3]) { return Vec3(a[0], a[1], a[2]); }
+
+struct RayQueryScene::Impl {
+    static constexpr int kBlock = 1024;    // rays per parallel_for index
+
+    Scene S;
+    std::vector<int> ids[3];               // public id per primitive, by kind (rect, tri, sphere)
+    int nextId = 0;
+    ThreadPool pool;
+
+    // current batch; the tasks are built once so a batch never allocates
+    std::mutex m;
+    const QueryRay* rays = nullptr;
+    QueryHit* hits = nullptr;
+    uint8_t* occ = nullptr;
+    size_t n = 0;
+    std::function<void(int,int)> closestTask, anyTask;
+
+    explicit Impl(int threads) : pool(threads) {
+        closestTask = [this](int b, int){ closest_range(size_t(b) * kBlock, std::min(n, size_t(b + 1) * kBlock)); };
+        anyTask     = [this](int b, int){ any_range(size_t(b) * kBlock, std::min(n, size_t(b + 1) * kBlock)); };
+    }
+
+    static Ray to_ray(const QueryRay& q) { return Ray(Vec3(q.ox, q.oy, q.oz), Vec3(q.dx, q.dy, q.dz)); }
+
+    void closest_range(size_t i0, size_t i1) const {
+        for (size_t i = i0; i < i1; ++i) {
+            auto h = S.trace_first(to_ray(rays[i]), rays[i].tmin, rays[i].tmax);
+            QueryHit& o = hits[i];
+            if (!h.hit) { o = QueryHit{}; o.prim = -1; continue; }
+            o.t = h.rec.t;
+            o.px = h.rec.p.x; o.py = h.rec.p.y; o.pz = h.rec.p.z;
+            o.nx = h.rec.n.x; o.ny = h.rec.n.y; o.nz = h.rec.n.z;
+            o.prim = ids[h.kind][h.index];
+            o.front = h.rec.front_face ? 1 : 0;
+        }
+    }
+
+    void any_range(size_t i0, size_t i1) const {
+        for (size_t i = i0; i < i1; ++i)
+            occ[i] = S.occluded(to_ray(rays[i]), rays[i].tmin, rays[i].tmax) ? 1 : 0;
+    }
+
+    // small batches run on the calling thread
+    void run(const std::function<void(int,int)>& task) {
+        int blocks = int((n + kBlock - 1) / kBlock);
+        if (blocks <= 1) { if (n) task(0, 0); return; }
+        pool.parallel_for(blocks, task);
+    }
+
+    // give ids to primitives appended since the last call
+    void assign_ids() {
+        auto sync = [&](std::vector<int>& v, size_t count){ while (v.size() < count) v.push_back(nextId++); };
+        sync(ids[0], S.prims<RectGeom>().size());
+        sync(ids[1], S.prims<TriGeom>().size());
+        sync(ids[2], S.prims<Sphere>().size());
+    }
+};
+
+RayQueryScene::RayQueryScene(int threads) : impl(new Impl(threads)) {}
+RayQueryScene::~RayQueryScene() = default;
+RayQueryScene::RayQueryScene(RayQueryScene&&) noexcept = default;
+RayQueryScene& RayQueryScene::operator=(RayQueryScene&&) noexcept = default;
+
+int RayQueryScene::add_triangle(const double a[3], const double b[3], const double c[3]) {
+    impl->S.add(TriGeom{ Triangle(v3(a), v3(b), v3(c)), Material() });
+    impl->assign_ids();
+    return impl->nextId - 1;
+}
+
+int RayQueryScene::add_rectangle(const double corner[3], const double e1[3], const double e2[3]) {
+    impl->S.add(RectGeom{ Rectangle(v3(corner), v3(e1), v3(e2)), Material() });
+    impl->assign_ids();
+    return impl->nextId - 1;
+}
+
+int RayQueryScene::add_sphere(const double center[3], double radius) {
+    impl->S.add(Sphere(v3(center), radius, Material()));
+    impl->assign_ids();
+    return impl->nextId - 1;
+}
+
+bool RayQueryScene::add_named(const char* id) {
+    Scene named;
+    if (!build_named_scene(id, named)) return false;
+    for (const auto& g : named.prims<RectGeom>()) impl->S.add(g);
+    for (const auto& g : named.prims<TriGeom>())  impl->S.add(g);
+    for (const auto& g : named.prims<Sphere>())   impl->S.add(g);
+    impl->assign_ids();
+    return true;
+}
+
+int RayQueryScene::primitive_count() const { return impl->nextId; }
+int RayQueryScene::threads() const { return impl->pool.size(); }
+
+void RayQueryScene::closest_hit(const QueryRay* rays, QueryHit* hits, size_t n) const {
+    std::lock_guard<std::mutex> lk(impl->m);
+    impl->rays = rays; impl->hits = hits; impl->n = n;
+    impl->run(impl->closestTask);
+}
+
+void RayQueryScene::any_hit(const QueryRay* rays, uint8_t* occluded, size_t n) const {
+    std::lock_guard<std::mutex> lk(impl->m);
+    impl->rays = rays; impl->occ = occluded; impl->n = n;
+    impl->run(impl->anyTask);
+}
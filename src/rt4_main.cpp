@@ -1,40 +1,30 @@
-#include <fstream>
+// Lambert shading under a fixed sun with hard shadows: sphere on a ground plane.
+//
+//   rt4_main [--w 600] [--spp 4] [--threads 0] [--out image4.ppm]  (see render_driver.h)
+#include <algorithm>
 #include "camera.h"
 #include "scene.h"
 #include "color.h"
+#include "render_driver.h"
 
-int main(){
-    const int image_width = 600;
-    const int image_height = static_cast<int>(image_width / (16.0/9.0));
-
-    Camera cam;
-    Scene scene;
+int main(int argc, char** argv){
+    DriverOptions o;
+    o.w = 600; o.aspect = 16.0/9.0; o.spp = 4; o.out = "image4.ppm";
+    if (!parse_driver_args(argc, argv, o)) return 1;
 
+    PlaneScene scene;
     // objects: sphere and a ground plane at z = -0.75
-    scene.spheres.emplace_back(Vec3(3, 0, -0.25), 0.75, Color(0.9, 0.2, 0.2)); // red sphere
-    scene.planes.push_back({ Scene::PlaneGeom{ Plane(Vec3(0,0,-0.75), Vec3(0,0,1)), Color(0.8,0.8,0.8) } });
-
-    std::ofstream out("image4.ppm", std::ios::binary);
-    out << "P6\n" << image_width << " " << image_height << "\n255\n";
-
-    for (int j = image_height - 1; j >= 0; --j){
-        for (int i = 0; i < image_width; ++i){
-            double u = double(i) / (image_width - 1);
-            double v = double(j) / (image_height - 1);
-            Ray r = cam.get_ray(u, v);
-
-            auto hit = scene.trace_first(r, 1e-4, 1e9);
-            Color c;
-            if (hit.hit){
-                c = scene.shade_lambert(hit);
-            } else {
-                c = scene.background(r);
-            }
+    scene.add(Sphere(Vec3(3, 0, -0.25), 0.75, Material(MatType::LAMBERT, Color(0.9, 0.2, 0.2)))); // red sphere
+    scene.add(PlaneGeom{ Plane(Vec3(0,0,-0.75), Vec3(0,0,1)), Material(MatType::LAMBERT, Color(0.8,0.8,0.8)) });
 
-            uint8_t R,G,B;
-            to_u8(c, R, G, B, 1.0);
-            out.put(char(R)).put(char(G)).put(char(B));
-        }
-    }
-    return 0;
+    const Vec3 sun = normalize(Vec3(-1, 1, 2));   // towards the sun
+    return render_shaded(o, Camera(), [&](const Ray& r, auto&){
+        auto h = scene.trace_first(r, 1e-4, 1e9);
+        if (!h.hit) return scene.background(r);
+        const Material* m = scene.material_of(h);
+        double c = std::max(0.0, dot(h.rec.n, sun));
+        if (c > 0 && scene.occluded(h.rec.p, sun, 1e9)) c = 0;
+        c = 0.15 + 0.85*c;                         // a little ambient
+        return Color(m->albedo.r*c, m->albedo.g*c, m->albedo.b*c);
+    }) ? 0 : 1;
 }
@@ -1,19 +1,22 @@
-#include <fstream>
-#include <random>
+// Spheres, ground and a green wall under a rectangular roof light (direct light MC).
+//
+//   rt6_main [--w 1080] [--spp 16] [--ls 16] [--d 8] [--seed 1] [--threads 0] [--out image6.ppm]
+//   (all options: render_driver.h)
 #include "camera.h"
 #include "scene.h"
 #include "material.h"
 #include "light.h"
 #include "color.h"
+#include "render_driver.h"
 
-int main(){
-    const int image_width  = 1080;
-    const int image_height = static_cast<int>(image_width / (16.0/9.0));
-    const int max_depth    = 8;
-    const int spp_direct   = 16;     // MC samples per pixel for direct light
+int main(int argc, char** argv){
+    DriverOptions o;
+    o.w = 1080; o.aspect = 16.0/9.0; o.spp = 16; o.p.depth = 8;
+    o.p.ls = 16;     // MC samples per hit for direct light
+    o.out = "image6.ppm";
+    if (!parse_driver_args(argc, argv, o)) return 1;
 
-    Camera cam;
-    Scene scene;
+    PlaneScene scene;
 
     // --- Materials ---
     Material redLambert  { MatType::LAMBERT, Color(0.9, 0.2, 0.2) };
@@ -22,14 +25,14 @@ int main(){
     Material mirror      { MatType::MIRROR , Color(0,0,0) };
 
     // --- Geometry (+x is forward) ---
-    scene.spheres.emplace_back(Vec3(3.0, -0.4, -0.25), 0.5, redLambert);
-    scene.spheres.emplace_back(Vec3(4.6,  0.7, -0.10), 0.6, mirror);
+    scene.add(Sphere(Vec3(3.0, -0.4, -0.25), 0.5, redLambert));
+    scene.add(Sphere(Vec3(4.6,  0.7, -0.10), 0.6, mirror));
 
     // Ground z = -0.75
-    scene.planes.push_back({ Plane(Vec3(0,0,-0.75), Vec3(0,0,1)), greyLambert });
+    scene.add(PlaneGeom{ Plane(Vec3(0,0,-0.75), Vec3(0,0,1)), greyLambert });
 
     // Optional: left wall at y = -1.2 (Lambert green)
-    scene.planes.push_back({ Plane(Vec3(0,-1.2,0), Vec3(0,1,0)), greenLambert });
+    scene.add(PlaneGeom{ Plane(Vec3(0,-1.2,0), Vec3(0,1,0)), greenLambert });
 
     // --- Rectangular roof light (z = +5, shining downward) ---
     // Square 4x4 centered around (x=4, y=0, z=5); edges along +y and +x.
@@ -39,25 +42,5 @@ int main(){
     Vec3 nL = Vec3(0, 0, -1);  // toward the room
     scene.lights.emplace_back(v0, e1, e2, nL, Color(1,1,1));  // Le=(1,1,1)
 
-    std::ofstream out("image6.ppm", std::ios::binary);
-    out << "P6\n" << image_width << " " << image_height << "\n255\n";
-
-    // simple RNG per render
-    std::random_device rd;
-    std::mt19937_64 rng(rd());
-
-    for (int j = image_height - 1; j >= 0; --j){
-        for (int i = 0; i < image_width; ++i){
-            double u = double(i) / (image_width - 1);
-            double v = double(j) / (image_height - 1);
-
-            Ray r = cam.get_ray(u, v);
-            Color c = scene.shade(r, max_depth, spp_direct, rng);
-
-            uint8_t R,G,B;
-            to_u8(c, R, G, B, 1.0);
-            out.put(char(R)).put(char(G)).put(char(B));
-        }
-    }
-    return 0;
+    return render_scene(o, scene) ? 0 : 1;
 }
@@ -0,0 +1,90 @@
+// Command-line job submitter for rt_daemon.
+//
+//   rt_client [--socket /tmp/raytracer.sock] [--scene room] [--w 64] [--h 64]
+//             [--spp 8] [--ls 4] [--d 8] [--seed 1] [--prio 0] [--eye -1,0,0]
+//             [--integrator path] [--sampler random] [--group ""] [--count 1]
+//             [--out preview.ppm]
+//
+// Submits --count identical jobs (ids 1..count) on one connection, assembles the
+// streamed row bands and writes each result as a PPM (preview_<id>.ppm when count > 1).
+// With --group each job supersedes the previous ones, so usually only the last finishes.
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "render_driver.h"
+#include "service_protocol.h"
+
+int main(int argc, char** argv){
+    std::string path = args("--socket", default_socket_path(), argc, argv);
+    int w     = argi("--w", 64, argc, argv);
+    int h     = argi("--h", w,  argc, argv);
+    int count = argi("--count", 1, argc, argv);
+    std::string out = args("--out", "preview.ppm", argc, argv);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = unix_address(path);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::cerr << "cannot connect to " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::string job = std::string("scene=") + args("--scene", "room", argc, argv)
+        + " w=" + std::to_string(w) + " h=" + std::to_string(h)
+        + " spp=" + std::to_string(argi("--spp", 8, argc, argv))
+        + " ls=" + std::to_string(argi("--ls", 4, argc, argv))
+        + " d=" + std::to_string(argi("--d", 8, argc, argv))
+        + " seed=" + args("--seed", "1", argc, argv)
+        + " prio=" + std::to_string(argi("--prio", 0, argc, argv))
+        + " eye=" + args("--eye", "-1,0,0", argc, argv)
+        + " integrator=" + args("--integrator", "path", argc, argv)
+        + " sampler=" + args("--sampler", "random", argc, argv);
+    if (*args("--group", "", argc, argv)) job += std::string(" group=") + args("--group", "", argc, argv);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int id = 1; id <= count; ++id)
+        if (!write_line(fd, "RENDER id=" + std::to_string(id) + " " + job)) { std::cerr << "send failed\n"; return 1; }
+
+    std::map<int, std::vector<uint8_t>> images;
+    SocketReader in(fd);
+    std::string line;
+    int remaining = count, failed = 0, cancelled = 0;
+    while (remaining > 0 && in.read_line(line)) {
+        char kind[16] = {0};
+        int id = 0, y0 = 0, y1 = 0; size_t n = 0;
+        std::sscanf(line.c_str(), "%15s %d", kind, &id);
+        if (!std::strcmp(kind, "ROWS")) {
+            std::sscanf(line.c_str(), "%*s %d %d %d %zu", &id, &y0, &y1, &n);
+            auto& img = images[id];
+            img.resize(size_t(w) * h * 3);
+            if (n != size_t(y1 - y0) * w * 3 || y1 > h || !in.read_bytes(reinterpret_cast<char*>(img.data()) + size_t(y0) * w * 3, n)) {
+                std::cerr << "bad ROWS message\n"; return 1;
+            }
+        } else if (!std::strcmp(kind, "DONE")) {
+            std::string name = count == 1 ? out
+                : out.substr(0, out.rfind('.')) + "_" + std::to_string(id) + out.substr(out.rfind('.'));
+            std::ofstream f(name, std::ios::binary);
+            f << "P6\n" << w << " " << h << "\n255\n";
+            f.write(reinterpret_cast<const char*>(images[id].data()), images[id].size());
+            images.erase(id);
+            --remaining;
+        } else if (!std::strcmp(kind, "ERROR")) {
+            std::cerr << line << "\n";
+            --remaining; ++failed;
+        } else if (!std::strcmp(kind, "CANCELLED")) {
+            images.erase(id);
+            --remaining; ++cancelled;
+        }
+    }
+    write_line(fd, "QUIT");
+    ::close(fd);
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << (count - remaining - failed - cancelled) << "/" << count << " jobs done";
+    if (cancelled) std::cout << " (" << cancelled << " cancelled)";
+    std::cout << " in " << sec << " s\n";
+    return (remaining || failed) ? 1 : 0;
+}
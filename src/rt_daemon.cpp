@@ -0,0 +1,255 @@
+// Long-running render service on a Unix domain socket.
+//
+//   rt_daemon [--socket /tmp/raytracer.sock] [--threads 0] [--cache 4]
+//
+// Scenes are built on first use and kept in an LRU cache, so repeated preview
+// jobs against the same scene skip the build entirely. Jobs from all clients go
+// into one priority queue (higher prio first, FIFO within a priority) and are
+// rendered one at a time on a shared thread pool; finished row bands are streamed
+// back to the submitting connection as they complete. CANCEL drops a queued job
+// or stops a running one at the next band; a RENDER with group=g does the same to
+// the connection's earlier jobs in that group, so an interactive client only pays
+// for its latest view. See service_protocol.h for the wire format.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "camera.h"
+#include "scene.h"
+#include "scene_registry.h"
+#include "film.h"
+#include "render.h"
+#include "render_driver.h"
+#include "thread_pool.h"
+#include "service_protocol.h"
+
+struct Connection {
+    int fd;
+    std::mutex wm;                     // one message at a time on the socket
+    std::atomic<bool> alive{true};
+    explicit Connection(int f) : fd(f) {}
+    ~Connection() { ::close(fd); }
+
+    bool send(const std::string& line, const std::vector<uint8_t>* payload = nullptr) {
+        if (!alive) return false;
+        std::lock_guard<std::mutex> lk(wm);
+        bool ok = write_line(fd, line) && (!payload || write_all(fd, payload->data(), payload->size()));
+        if (!ok) alive = false;
+        return ok;
+    }
+};
+
+struct Job {
+    int id = 0, prio = 0;
+    uint64_t seq = 0;
+    std::string scene, group;
+    int w = 64, h = 64, spp = 8;
+    Vec3 eye{-1,0,0};
+    RenderParams p;
+    std::shared_ptr<Connection> conn;
+    std::atomic<bool> cancelled{false};
+};
+
+// LRU of built scenes. Scenes are immutable once built and shared by pointer,
+// so an evicted scene stays alive until the job using it finishes.
+struct SceneCache {
+    size_t capacity;
+    std::mutex m;
+    std::list<std::pair<std::string, std::shared_ptr<const Scene>>> lru;  // front = most recent
+    std::unordered_map<std::string, decltype(lru)::iterator> index;
+    int hits = 0, misses = 0;
+
+    explicit SceneCache(size_t cap) : capacity(std::max<size_t>(1, cap)) {}
+
+    std::shared_ptr<const Scene> get(const std::string& id) {
+        std::lock_guard<std::mutex> lk(m);
+        auto it = index.find(id);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            ++hits;
+            return it->second->second;
+        }
+        auto s = std::make_shared<Scene>();
+        if (!build_named_scene(id, *s)) return nullptr;
+        ++misses;
+        lru.emplace_front(id, s);
+        index[id] = lru.begin();
+        if (lru.size() > capacity) { index.erase(lru.back().first); lru.pop_back(); }
+        return s;
+    }
+};
+
+struct JobQueue {
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<Job>> pending;
+    std::shared_ptr<Job> running;
+    uint64_t nextSeq = 0;
+
+    void push(std::shared_ptr<Job> j) {
+        { std::lock_guard<std::mutex> lk(m); j->seq = nextSeq++; pending.push_back(std::move(j)); }
+        cv.notify_one();
+    }
+
+    std::shared_ptr<Job> pop() {
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&]{ return !pending.empty(); });
+        auto best = std::max_element(pending.begin(), pending.end(), [](const auto& a, const auto& b){
+            return a->prio != b->prio ? a->prio < b->prio : a->seq > b->seq;
+        });
+        running = *best;
+        pending.erase(best);
+        return running;
+    }
+
+    void finished() { std::lock_guard<std::mutex> lk(m); running.reset(); }
+
+    // removes a queued job (returns it) or flags the running one
+    std::shared_ptr<Job> cancel(const Connection* c, int id) {
+        std::lock_guard<std::mutex> lk(m);
+        for (auto it = pending.begin(); it != pending.end(); ++it)
+            if ((*it)->conn.get() == c && (*it)->id == id) { auto j = *it; pending.erase(it); return j; }
+        if (running && running->conn.get() == c && running->id == id) running->cancelled = true;
+        return nullptr;
+    }
+
+    // removes c's queued jobs in group g (returned) and flags a running one
+    std::vector<std::shared_ptr<Job>> supersede(const Connection* c, const std::string& g) {
+        std::lock_guard<std::mutex> lk(m);
+        std::vector<std::shared_ptr<Job>> dropped;
+        auto old = [&](const auto& j){ return j->conn.get() == c && j->group == g; };
+        for (const auto& j : pending) if (old(j)) dropped.push_back(j);
+        pending.erase(std::remove_if(pending.begin(), pending.end(), old), pending.end());
+        if (running && old(running)) running->cancelled = true;
+        return dropped;
+    }
+
+    void drop_connection(const Connection* c) {
+        std::lock_guard<std::mutex> lk(m);
+        pending.erase(std::remove_if(pending.begin(), pending.end(),
+                      [&](const auto& j){ return j->conn.get() == c; }), pending.end());
+        if (running && running->conn.get() == c) running->cancelled = true;
+    }
+};
+
+static void run_job(Job& job, ThreadPool& pool, SceneCache& cache) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto scene = cache.get(job.scene);
+    if (!scene) { job.conn->send("ERROR " + std::to_string(job.id) + " unknown scene " + job.scene); return; }
+
+    Camera cam(job.eye);
+    Film film(job.w, job.h);
+    const int band = std::max(4, 2 * pool.size());
+    std::vector<uint8_t> bytes;
+    for (int y0 = 0; y0 < job.h; y0 += band) {
+        if (job.cancelled || !job.conn->alive) { job.conn->send("CANCELLED " + std::to_string(job.id)); return; }
+        int y1 = std::min(job.h, y0 + band);
+        // image row y is film row H-1-y
+        render_rows(pool, *scene, cam, film, job.h - y1, job.h - y0, 0, job.spp, job.p);
+        bytes.resize(size_t(y1 - y0) * job.w * 3);
+        for (int y = y0; y < y1; ++y)
+            for (int i = 0; i < job.w; ++i) {
+                size_t idx = (size_t(y - y0) * job.w + i) * 3;
+                to_u8(film.at(i, job.h-1-y) * (1.0/job.spp), bytes[idx], bytes[idx+1], bytes[idx+2], 1.0);
+            }
+        job.conn->send("ROWS " + std::to_string(job.id) + " " + std::to_string(y0) + " " + std::to_string(y1)
+                       + " " + std::to_string(bytes.size()), &bytes);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    job.conn->send("DONE " + std::to_string(job.id) + " " + std::to_string(sec));
+    std::cerr << "job " << job.id << " " << job.scene << " " << job.w << "x" << job.h << "x" << job.spp
+              << " in " << sec << " s (scene cache " << cache.hits << " hits, " << cache.misses << " builds)\n";
+}
+
+static void serve_connection(std::shared_ptr<Connection> conn, JobQueue& queue) {
+    SocketReader in(conn->fd);
+    std::string line;
+    while (conn->alive && in.read_line(line)) {
+        std::map<std::string, std::string> kv;
+        std::string cmd = parse_command(line, kv);
+        int id = 0;
+        if (!kv_int(kv, "id", id)) { conn->send("ERROR 0 bad id " + kv_str(kv, "id", "")); continue; }
+        if (cmd == "RENDER") {
+            auto j = std::make_shared<Job>();
+            j->id = id; j->conn = conn;
+            j->scene = kv_str(kv, "scene", "room");
+            j->group = kv_str(kv, "group", "");
+            j->p.ls = 4; j->p.depth = 8; j->p.seed = 1;
+            bool ok = kv_int(kv, "w", j->w);
+            j->h = j->w;
+            ok = ok && kv_int(kv, "h", j->h) && kv_int(kv, "spp", j->spp) && kv_int(kv, "prio", j->prio)
+                 && kv_int(kv, "ls", j->p.ls) && kv_int(kv, "d", j->p.depth) && kv_int(kv, "seed", j->p.seed);
+            j->p.spp = j->spp;
+            std::string eye = kv_str(kv, "eye", "");
+            char tail = 0;
+            if (!eye.empty() && std::sscanf(eye.c_str(), "%lf,%lf,%lf%c", &j->eye.x, &j->eye.y, &j->eye.z, &tail) != 3) ok = false;
+            if (!ok || j->w < 2 || j->h < 2 || j->w > 16384 || j->h > 16384 || j->spp < 1 ||
+                !parse_integrator(kv_str(kv, "integrator", "path").c_str(), j->p.integrator) ||
+                !parse_sampler(kv_str(kv, "sampler", "random").c_str(), j->p.sampler)) {
+                conn->send("ERROR " + std::to_string(id) + " bad parameters");
+                continue;
+            }
+            if (!j->group.empty())
+                for (const auto& old : queue.supersede(conn.get(), j->group)) conn->send("CANCELLED " + std::to_string(old->id));
+            conn->send("QUEUED " + std::to_string(id));
+            queue.push(j);
+        } else if (cmd == "CANCEL") {
+            if (queue.cancel(conn.get(), id)) conn->send("CANCELLED " + std::to_string(id));
+        } else if (cmd == "QUIT") {
+            break;
+        } else if (!cmd.empty()) {
+            conn->send("ERROR " + std::to_string(id) + " unknown command " + cmd);
+        }
+    }
+    conn->alive = false;
+    queue.drop_connection(conn.get());
+}
+
+int main(int argc, char** argv){
+    std::string path = args("--socket", default_socket_path(), argc, argv);
+    int threads = argi("--threads", 0, argc, argv);
+    int cacheSize = argi("--cache", 4, argc, argv);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = unix_address(path);
+    ::unlink(path.c_str());
+    if (lfd < 0 || ::bind(lfd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(lfd, 64) < 0) {
+        std::cerr << "cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    SceneCache cache(cacheSize);
+    JobQueue queue;
+    std::cerr << "rt_daemon on " << path << " (" << pool.size() << " threads, cache " << cacheSize << ")\n";
+
+    std::thread scheduler([&]{
+        while (true) {
+            auto job = queue.pop();
+            if (job->cancelled || !job->conn->alive) job->conn->send("CANCELLED " + std::to_string(job->id));
+            else run_job(*job, pool, cache);
+            queue.finished();
+        }
+    });
+    scheduler.detach();
+
+    while (true) {
+        int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0) { if (errno == EINTR) continue; break; }
+        std::thread(serve_connection, std::make_shared<Connection>(fd), std::ref(queue)).detach();
+    }
+    ::close(lfd);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Parameter sweep over the hex room: one scene, one thread pool, nested spp.
+//
+//   rt_sweep --configs "1:8:8:400,2:8:8:400,4:8:8:400,32:8:8:400,20:40:4:400"
+//            [--seed 1] [--threads 0] [--prefix room_] [--integrator path|mis|bdpt]
+//            [--scene room|room_empty] [--sampler random|sobol|zsobol]
+//
+// Each config is spp:ls:depth:width. Configs that share (width, ls, depth) are
+// rendered as one progressive run; when the accumulated sample count reaches a
+// requested spp the image is written and sampling simply continues, so the
+// 1, 2, 4 ... 32 spp images cost exactly as much as the 32 spp one alone.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "camera.h"
+#include "scene.h"
+#include "hex_room.h"
+#include "film.h"
+#include "render.h"
+#include "render_driver.h"
+#include "thread_pool.h"
+
+struct SweepConfig { int spp, ls, depth, w; };
+
+static std::vector<SweepConfig> parse_configs(const std::string& s){
+    std::vector<SweepConfig> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')){
+        SweepConfig c{};
+        if (std::sscanf(item.c_str(), "%d:%d:%d:%d", &c.spp, &c.ls, &c.depth, &c.w) == 4 && c.spp > 0 && c.w > 1)
+            out.push_back(c);
+        else
+            std::cerr << "ignoring bad config '" << item << "' (want spp:ls:depth:width)\n";
+    }
+    return out;
+}
+
+// group by everything except spp; within a group the spp targets are nested
+template <class SceneType>
+static long long run_sweep(const SceneType& scene, ThreadPool& pool, const std::vector<SweepConfig>& configs,
+                           const RenderParams& base, const std::string& prefix){
+    Camera cam;
+    std::map<std::tuple<int,int,int>, std::vector<int>> groups;
+    for (const auto& c : configs) groups[{c.w, c.ls, c.depth}].push_back(c.spp);
+
+    long long traced = 0;
+    for (auto& [key, spps] : groups){
+        auto [w, ls, depth] = key;
+        std::sort(spps.begin(), spps.end());
+        spps.erase(std::unique(spps.begin(), spps.end()), spps.end());
+
+        RenderParams p = base; p.ls = ls; p.depth = depth; p.spp = spps.back();
+        Film film(w, w);
+        for (int target : spps){
+            auto ts = std::chrono::steady_clock::now();
+            render_samples(pool, scene, cam, film, film.samples, target, p);
+            std::string name = prefix + std::to_string(target) + "_" + std::to_string(ls) + "_"
+                             + std::to_string(depth) + "_" + std::to_string(w) + ".ppm";
+            write_ppm(name, film);
+            std::cerr << name << ": +" << std::chrono::duration<double>(std::chrono::steady_clock::now() - ts).count()
+                      << " s\n";
+        }
+        traced += (long long)spps.back() * w * w;
+    }
+    return traced;
+}
+
+int main(int argc, char** argv){
+    std::vector<SweepConfig> configs = parse_configs(
+        args("--configs", "1:8:8:400,2:8:8:400,4:8:8:400,8:8:8:400,32:8:8:400", argc, argv));
+    RenderParams base;
+    int threads   = argi("--threads", 0, argc, argv);
+    std::string prefix = args("--prefix", "room_", argc, argv);
+    std::string sceneId = args("--scene", "room", argc, argv);
+    if (configs.empty()) return 1;
+    if (!argu64("--seed", base.seed, argc, argv)) { std::cerr << "--seed must be an unsigned 64-bit integer\n"; return 1; }
+    if (!parse_integrator(args("--integrator", "path", argc, argv), base.integrator)) {
+        std::cerr << "unknown --integrator\n"; return 1;
+    }
+    if (!parse_sampler(args("--sampler", "random", argc, argv), base.sampler)) {
+        std::cerr << "unknown --sampler\n"; return 1;
+    }
+
+    ThreadPool pool(threads);
+    auto t0 = std::chrono::steady_clock::now();
+    long long traced = 0;
+    if (sceneId == "room_empty") {
+        BareRoomScene scene;          // specialised: no spheres, no mirrors
+        build_bare_room(scene);
+        traced = run_sweep(scene, pool, configs, base, prefix);
+    } else if (sceneId == "room") {
+        Scene scene;
+        build_hex_room_scene(scene);
+        traced = run_sweep(scene, pool, configs, base, prefix);
+    } else {
+        std::cerr << "unknown --scene " << sceneId << "\n"; return 1;
+    }
+
+    std::cerr << "Sweep of " << configs.size() << " configs (" << traced << " camera samples) in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() << " s on "
+              << pool.size() << " threads\n";
+    return 0;
+}